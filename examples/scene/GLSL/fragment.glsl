@@ -3,10 +3,28 @@
 in vec3 v_normal;
 in vec2 v_uv;
 in vec3 v_fragment_position;
+flat in uint v_object;
 out vec4 frag_color;
 
-uniform sampler2D diffuse_texture;
-uniform sampler2D specular_texture;
+uniform sampler2DArray diffuse_texture;
+uniform sampler2DArray specular_texture;
+
+// see vertex.glsl. The textures are regions of atlas pages, uvs are mapped
+// as `uv * rect.zw + rect.xy`, the pages are layers of texture arrays
+struct Object {
+    vec4 position_offset;
+    vec4 position_scale;
+    vec4 diffuse_uv_rect;
+    vec4 specular_uv_rect;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular_shininess;
+    ivec4 layers;
+};
+
+layout (std430, binding = 0) readonly buffer Objects {
+    Object objects[];
+};
 
 uniform vec3 light_position;
 uniform vec3 camera_position;
@@ -22,29 +40,24 @@ uniform struct {
 };
 
 
-uniform struct {
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-    float shininess;
-} material;
-
 void main()
 {
+    Object object = objects[v_object];
+
     // ambient
-    vec3 ambient = light.ambient * material.ambient;
+    vec3 ambient = light.ambient * object.ambient.rgb;
 
     // diffuse
     vec3 norm = normalize(v_normal);
     vec3 light_dir = normalize(light_position - v_fragment_position);
     float diff = max(dot(norm, light_dir), 0.0);
-    vec3 diffuse = light.diffuse * (diff * material.diffuse * texture(diffuse_texture, v_uv).rgb);
+    vec3 diffuse = light.diffuse * (diff * object.diffuse.rgb * texture(diffuse_texture, vec3(v_uv * object.diffuse_uv_rect.zw + object.diffuse_uv_rect.xy, object.layers.x)).rgb);
 
     // specular
     vec3 view_dir = normalize(camera_position - v_fragment_position);
     vec3 reflect_dir = reflect(-light_dir, norm);
-    float spec = pow(max(dot(view_dir, reflect_dir), 0.0F), material.shininess);
-    vec3 specular = light.specular * (spec * material.specular * vec3(texture(specular_texture, v_uv).r));
+    float spec = pow(max(dot(view_dir, reflect_dir), 0.0F), object.specular_shininess.w);
+    vec3 specular = light.specular * (spec * object.specular_shininess.rgb * vec3(texture(specular_texture, vec3(v_uv * object.specular_uv_rect.zw + object.specular_uv_rect.xy, object.layers.y)).r));
 
     vec3 res = ambient + diffuse + specular;
 
@@ -6,6 +6,10 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 proj;
 
+// see vertex.glsl
+uniform vec3 position_offset = vec3(0.0);
+uniform vec3 position_scale = vec3(1.0);
+
 void main() {
-    gl_Position = proj * view * model * vec4(position, 1.0);
-}
\ No newline at end of file
+    gl_Position = proj * view * model * vec4(position_offset + position * position_scale, 1.0);
+}
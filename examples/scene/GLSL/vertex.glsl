@@ -8,15 +8,57 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 proj;
 
+// the data of every object drawn in the frame, laid out as `ObjectRecord` in scene.hpp.
+// Packed vertices store positions normalized within the bounds of their mesh,
+// which `position_offset` and `position_scale` map back
+struct Object {
+    vec4 position_offset;
+    vec4 position_scale;
+    vec4 diffuse_uv_rect;
+    vec4 specular_uv_rect;
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular_shininess;
+    ivec4 layers;
+};
+
+layout (std430, binding = 0) readonly buffer Objects {
+    Object objects[];
+};
+
+// the object of every draw of a multi draw call, at `first_draw + gl_DrawID`
+layout (std430, binding = 1) readonly buffer DrawObjects {
+    uint draw_objects[];
+};
+
+uniform int first_draw = 0;
+
+// packed vertices store normals octahedral-encoded in the first two components
+uniform bool octahedral_normals = false;
+
 out vec3 v_normal;
 out vec2 v_uv;
 out vec3 v_fragment_position;
+flat out uint v_object;
+
+vec3 octahedral_decode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
 
 void main()
 {
-    v_normal = normal;
+    v_object = draw_objects[first_draw + gl_DrawID];
+    Object object = objects[v_object];
+    vec3 model_position = object.position_offset.xyz + position * object.position_scale.xyz;
+
+    v_normal = octahedral_normals ? octahedral_decode(normal.xy) : normal;
     v_uv = uv;
 
-    gl_Position = proj * view * model * vec4(position, 1.0);
-    v_fragment_position = vec3(model * vec4(position, 1.0));
+    gl_Position = proj * view * model * vec4(model_position, 1.0);
+    v_fragment_position = vec3(model * vec4(model_position, 1.0));
 }
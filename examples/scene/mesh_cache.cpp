@@ -0,0 +1,326 @@
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+#include <spdlog/spdlog.h>
+
+#include "../../playground/hash.hpp"
+#include "../../playground/mapped_file.hpp"
+#include "mesh_cache.hpp"
+#include "mesh_codec.hpp"
+
+// bump the version whenever the layout of the file or the way models are built changes
+static uint32_t const mesh_cache_version = 6;
+static std::array<char, 8> const mesh_cache_magic{'P', 'G', 'M', 'E', 'S', 'H', '\0', '\0'};
+
+struct MeshCacheHeader {
+    std::array<char, 8> magic{};
+    uint32_t version{};
+    uint32_t vertex_size{};
+    uint64_t source_hash{};
+    uint64_t payload_hash{};
+    uint64_t vertex_count{};
+    uint64_t index_count{};
+    uint64_t lod_count{};
+    // size of the vertices and indices in the file, which differs from their size in memory when compressed
+    uint64_t data_size{};
+    uint32_t compression{};
+    uint32_t reserved{};
+    glm::vec3 min_bound{0.0F};
+    glm::vec3 max_bound{0.0F};
+};
+
+// fixed-size version of MeshLod without padding, so the file content is deterministic
+struct MeshCacheLod {
+    uint64_t index_offset{};
+    uint64_t index_count{};
+    float error{};
+    uint32_t reserved{};
+};
+
+// vertices are copied straight out of the mapped file right after the header
+static_assert(std::is_trivially_copyable_v<Vertex>);
+static_assert(std::is_trivially_copyable_v<MeshCacheHeader>);
+static_assert(sizeof(MeshCacheLod) == 24);
+static_assert(sizeof(MeshCacheHeader) % alignof(Vertex) == 0);
+
+std::string mesh_cache_path(std::string const& source_path)
+{
+    return source_path + ".mesh";
+}
+
+std::string mapped_mesh_cache_path(std::string const& source_path)
+{
+    return source_path + ".mesh.raw";
+}
+
+// the header and the levels of detail of a cache file which is neither stale nor corrupt
+struct MeshCacheContents {
+    MeshCacheHeader header{};
+    std::span<std::byte const> payload{};
+    std::vector<MeshLod> lods{};
+};
+
+/*
+ * the sizes in the header are always checked against the file,
+ * the payload hash only with `verify_payload`, it takes a pass over the whole file
+ */
+static std::optional<MeshCacheContents> validate_mesh_cache(
+  std::span<std::byte const> bytes, std::string const& cache_path, uint64_t source_hash, bool verify_payload)
+{
+    MeshCacheHeader header{};
+    if (bytes.size() < sizeof(header)) {
+        spdlog::warn("mesh cache `{}` is truncated", cache_path);
+        return std::nullopt;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    if (header.magic != mesh_cache_magic || header.version != mesh_cache_version || header.vertex_size != sizeof(Vertex)) {
+        spdlog::info("mesh cache `{}` has an outdated format", cache_path);
+        return std::nullopt;
+    }
+
+    if (header.source_hash != source_hash) {
+        spdlog::info("mesh cache `{}` is stale", cache_path);
+        return std::nullopt;
+    }
+
+    auto const payload = bytes.subspan(sizeof(header));
+    auto const vertices_size = header.vertex_count * sizeof(Vertex);
+    auto const indices_size = header.index_count * sizeof(uint32_t);
+    auto const lods_size = header.lod_count * sizeof(MeshCacheLod);
+    auto const compression = static_cast<MeshCompression>(header.compression);
+    bool const valid_layout = compression == MeshCompression::Deflate
+      || (compression == MeshCompression::None && header.data_size == vertices_size + indices_size);
+    if (!valid_layout || payload.size() != header.data_size + lods_size
+      || (verify_payload && playground::hash_bytes(payload) != header.payload_hash)) {
+        spdlog::warn("mesh cache `{}` is corrupt", cache_path);
+        return std::nullopt;
+    }
+
+    // levels of detail follow the indices and are not necessarily aligned for 64-bit reads
+    std::vector<MeshLod> lods(header.lod_count);
+    for (size_t i = 0; i < lods.size(); ++i) {
+        MeshCacheLod lod{};
+        std::memcpy(&lod, payload.data() + header.data_size + i * sizeof(lod), sizeof(lod));
+        if (lod.index_offset + lod.index_count > header.index_count) {
+            spdlog::warn("mesh cache `{}` is corrupt", cache_path);
+            return std::nullopt;
+        }
+        lods[i] = {lod.index_offset, lod.index_count, lod.error};
+    }
+
+    return MeshCacheContents{header, payload, std::move(lods)};
+}
+
+std::optional<VertexModel> read_mesh_cache(std::string const& cache_path, uint64_t source_hash)
+{
+    if (!std::filesystem::exists(cache_path)) {
+        return std::nullopt;
+    }
+
+    playground::MappedFile const file{cache_path};
+    auto contents = validate_mesh_cache(file.bytes(), cache_path, source_hash, true);
+    if (!contents) {
+        return std::nullopt;
+    }
+
+    auto const& header = contents->header;
+    auto const payload = contents->payload;
+    auto lods = std::move(contents->lods);
+    auto const vertices_size = header.vertex_count * sizeof(Vertex);
+    auto const indices_size = header.index_count * sizeof(uint32_t);
+    auto const compression = static_cast<MeshCompression>(header.compression);
+
+    if (compression == MeshCompression::None) {
+        auto const* vertices = reinterpret_cast<Vertex const*>(payload.data());
+        auto const* indices = reinterpret_cast<uint32_t const*>(payload.data() + vertices_size);
+        return VertexModel{
+          {vertices, vertices + header.vertex_count},
+          {indices, indices + header.index_count},
+          std::move(lods),
+          header.min_bound,
+          header.max_bound};
+    }
+
+    VertexModel res{
+      std::vector<Vertex>(header.vertex_count, Vertex{glm::vec3{0.0F}, glm::vec3{0.0F}}),
+      std::vector<uint32_t>(header.index_count),
+      std::move(lods),
+      header.min_bound,
+      header.max_bound};
+
+    auto const decode_start = std::chrono::steady_clock::now();
+    try {
+        decode_mesh_data(payload.first(header.data_size), res.vertices, res.indices);
+    } catch (std::exception const& e) {
+        spdlog::warn("mesh cache `{}` is corrupt: {}", cache_path, e.what());
+        return std::nullopt;
+    }
+    std::chrono::duration<double> const decode_time = std::chrono::steady_clock::now() - decode_start;
+
+    auto const decoded_megabytes = static_cast<double>(vertices_size + indices_size) / (1024.0 * 1024.0);
+    spdlog::info("decoded mesh cache `{}` in {:.1f} ms: ratio {:.2f}, {:.0f} MB/s",
+      cache_path, decode_time.count() * 1000.0,
+      static_cast<double>(vertices_size + indices_size) / static_cast<double>(header.data_size),
+      decoded_megabytes / decode_time.count());
+
+    return res;
+}
+
+std::optional<MappedVertexModel> map_mesh_cache(std::string const& cache_path, uint64_t source_hash)
+{
+    if (!std::filesystem::exists(cache_path)) {
+        return std::nullopt;
+    }
+
+    auto file = std::make_shared<playground::MappedFile const>(cache_path, playground::MappedAccess::Normal);
+    // the payload is not hashed, only the pages which are actually read are read in
+    auto contents = validate_mesh_cache(file->bytes(), cache_path, source_hash, false);
+    if (!contents) {
+        return std::nullopt;
+    }
+
+    auto const& header = contents->header;
+    if (static_cast<MeshCompression>(header.compression) != MeshCompression::None) {
+        spdlog::info("mesh cache `{}` is compressed and can not be mapped", cache_path);
+        return std::nullopt;
+    }
+
+    auto const* vertices = reinterpret_cast<Vertex const*>(contents->payload.data());
+    auto const* indices = reinterpret_cast<uint32_t const*>(contents->payload.data() + header.vertex_count * sizeof(Vertex));
+    return MappedVertexModel{
+      std::move(file),
+      {vertices, header.vertex_count},
+      {indices, header.index_count},
+      std::move(contents->lods),
+      header.min_bound,
+      header.max_bound};
+}
+
+void write_mesh_cache(
+  std::string const& cache_path, uint64_t source_hash, VertexModel const& model, MeshCompression compression)
+{
+    if (compression == MeshCompression::None) {
+        MeshCacheSink sink{cache_path, source_hash};
+        sink.begin({model.vertices.size(), model.indices.size(), model.lods, model.min_bound, model.max_bound});
+        sink.write_vertices(0, model.vertices);
+        sink.write_indices(0, model.indices);
+        sink.end();
+        return;
+    }
+
+    auto const encode_start = std::chrono::steady_clock::now();
+    auto payload = encode_mesh_data(model.vertices, model.indices);
+    std::chrono::duration<double> const encode_time = std::chrono::steady_clock::now() - encode_start;
+
+    auto const data_size = payload.size();
+    auto const raw_size = model.vertices.size() * sizeof(Vertex) + model.indices.size() * sizeof(uint32_t);
+    spdlog::info("encoded mesh cache `{}` in {:.1f} ms: {} -> {} bytes, ratio {:.2f}",
+      cache_path, encode_time.count() * 1000.0, raw_size, data_size,
+      static_cast<double>(raw_size) / static_cast<double>(data_size));
+
+    for (auto const& lod : model.lods) {
+        MeshCacheLod const record{lod.index_offset, lod.index_count, lod.error};
+        auto const bytes = std::as_bytes(std::span{&record, 1});
+        payload.insert(payload.end(), bytes.begin(), bytes.end());
+    }
+
+    // the payload is hashed as one range when it is read back
+    MeshCacheHeader const header{
+      mesh_cache_magic,
+      mesh_cache_version,
+      sizeof(Vertex),
+      source_hash,
+      playground::hash_bytes(payload),
+      model.vertices.size(),
+      model.indices.size(),
+      model.lods.size(),
+      data_size,
+      static_cast<uint32_t>(compression),
+      0,
+      model.min_bound,
+      model.max_bound};
+
+    // concurrent loads of the same model write their own files, the last rename wins
+    auto const temporary_path = playground::temporary_path(cache_path);
+    {
+        std::ofstream out{temporary_path, std::ios::binary | std::ios::trunc};
+        if (!out) {
+            throw std::runtime_error(fmt::format("could not create `{}`", temporary_path));
+        }
+        out.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+        out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        out.write(reinterpret_cast<char const*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+    }
+    std::filesystem::rename(temporary_path, cache_path);
+}
+
+MeshCacheSink::MeshCacheSink(std::string cache_path, uint64_t source_hash) :
+  cache_path_{std::move(cache_path)}, temporary_path_{playground::temporary_path(cache_path_)}, source_hash_{source_hash} {}
+
+void MeshCacheSink::begin(MeshLayout const& layout)
+{
+    layout_ = layout;
+    auto const size = sizeof(MeshCacheHeader)
+      + layout.vertex_count * sizeof(Vertex)
+      + layout.index_count * sizeof(uint32_t)
+      + layout.lods.size() * sizeof(MeshCacheLod);
+    file_ = std::make_unique<playground::WritableMappedFile>(temporary_path_, size);
+}
+
+void MeshCacheSink::write_vertices(size_t first_vertex, std::span<Vertex const> vertices)
+{
+    if (first_vertex + vertices.size() > layout_.vertex_count) {
+        throw std::runtime_error("vertices out of range");
+    }
+    auto const offset = sizeof(MeshCacheHeader) + first_vertex * sizeof(Vertex);
+    std::memcpy(file_->bytes().data() + offset, vertices.data(), vertices.size_bytes());
+}
+
+void MeshCacheSink::write_indices(size_t first_index, std::span<uint32_t const> indices)
+{
+    if (first_index + indices.size() > layout_.index_count) {
+        throw std::runtime_error("indices out of range");
+    }
+    auto const offset = sizeof(MeshCacheHeader) + layout_.vertex_count * sizeof(Vertex) + first_index * sizeof(uint32_t);
+    std::memcpy(file_->bytes().data() + offset, indices.data(), indices.size_bytes());
+}
+
+void MeshCacheSink::end()
+{
+    auto const bytes = file_->bytes();
+    auto const payload = bytes.subspan(sizeof(MeshCacheHeader));
+
+    auto lod_offset = layout_.vertex_count * sizeof(Vertex) + layout_.index_count * sizeof(uint32_t);
+    for (auto const& lod : layout_.lods) {
+        MeshCacheLod const record{lod.index_offset, lod.index_count, lod.error};
+        std::memcpy(payload.data() + lod_offset, &record, sizeof(record));
+        lod_offset += sizeof(record);
+    }
+
+    // the payload is hashed as one range when it is read back
+    MeshCacheHeader const header{
+      mesh_cache_magic,
+      mesh_cache_version,
+      sizeof(Vertex),
+      source_hash_,
+      playground::hash_bytes(payload),
+      layout_.vertex_count,
+      layout_.index_count,
+      layout_.lods.size(),
+      lod_offset - layout_.lods.size() * sizeof(MeshCacheLod),
+      static_cast<uint32_t>(MeshCompression::None),
+      0,
+      layout_.min_bound,
+      layout_.max_bound};
+    std::memcpy(bytes.data(), &header, sizeof(header));
+
+    file_.reset();
+    std::filesystem::rename(temporary_path_, cache_path_);
+}
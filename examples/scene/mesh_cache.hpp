@@ -0,0 +1,94 @@
+#ifndef PLAYGROUND_MESH_CACHE_HPP
+#define PLAYGROUND_MESH_CACHE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../../playground/mapped_file.hpp"
+#include "mesh_codec.hpp"
+#include "mesh_converter.hpp"
+#include "vertex.hpp"
+
+/*******************************************************************************
+ * Baked models are stored in a binary file next to their source:
+ * a fixed-size header followed by the vertices and the indices exactly as
+ * they are laid out in memory, so a mapped file can be copied into a VBO
+ * and an IBO as is, or encoded with `encode_mesh_data`,
+ * and the index ranges of the levels of detail.
+ * The header records the hash of the source file and of the load options
+ * the model was built from, a cache file with a different hash, version or
+ * layout is considered stale.
+ ******************************************************************************/
+std::string mesh_cache_path(std::string const& source_path);
+
+/*******************************************************************************
+ * uncompressed baked models to be mapped have their own file, so they never
+ * replace the compressed cache of the same model or the other way around
+ ******************************************************************************/
+std::string mapped_mesh_cache_path(std::string const& source_path);
+
+/*******************************************************************************
+ * reads a baked model, returns nothing if the file is missing, stale or corrupt
+ ******************************************************************************/
+std::optional<VertexModel> read_mesh_cache(std::string const& cache_path, uint64_t source_hash);
+
+/*******************************************************************************
+ * a baked model read in place from its mapped cache file, the spans are valid
+ * as long as the file is held. The pages of the file are read in on demand and
+ * dropped under memory pressure, so the model may be larger than the memory
+ ******************************************************************************/
+struct MappedVertexModel {
+    std::shared_ptr<playground::MappedFile const> file{};
+    std::span<Vertex const> vertices{};
+    std::span<uint32_t const> indices{};
+    std::vector<MeshLod> lods{};
+    glm::vec3 min_bound{0.0F};
+    glm::vec3 max_bound{0.0F};
+};
+
+/*******************************************************************************
+ * maps an uncompressed baked model, returns nothing if the file is missing,
+ * stale, corrupt or compressed. The header is checked against the file,
+ * the payload is trusted, hashing it would read all of it
+ ******************************************************************************/
+std::optional<MappedVertexModel> map_mesh_cache(std::string const& cache_path, uint64_t source_hash);
+
+/*******************************************************************************
+ * writes a baked model, the file is replaced atomically, so readers
+ * never observe a partially written cache
+ ******************************************************************************/
+void write_mesh_cache(
+  std::string const& cache_path,
+  uint64_t source_hash,
+  VertexModel const& model,
+  MeshCompression compression = MeshCompression::Deflate);
+
+/*******************************************************************************
+ * writes an uncompressed baked model chunk by chunk straight into a mapped file,
+ * the file is replaced atomically at `end` just like with `write_mesh_cache`
+ ******************************************************************************/
+class MeshCacheSink final : public MeshSink {
+public:
+    MeshCacheSink(std::string cache_path, uint64_t source_hash);
+
+    void begin(MeshLayout const& layout) override;
+
+    void write_vertices(size_t first_vertex, std::span<Vertex const> vertices) override;
+
+    void write_indices(size_t first_index, std::span<uint32_t const> indices) override;
+
+    void end() override;
+
+private:
+    std::string cache_path_;
+    std::string temporary_path_;
+    uint64_t source_hash_;
+    MeshLayout layout_{};
+    std::unique_ptr<playground::WritableMappedFile> file_{};
+};
+
+#endif // PLAYGROUND_MESH_CACHE_HPP
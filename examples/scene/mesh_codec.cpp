@@ -0,0 +1,243 @@
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#include <fmt/format.h>
+#include <zlib.h>
+
+#include "mesh_codec.hpp"
+#include "vertex.hpp"
+
+// blocks are large enough for deflate to find its matches
+// and small enough to keep every core busy on a mesh of a few megabytes
+static size_t const vertex_block_size = 64UL * 1024UL;
+static size_t const index_block_size = 256UL * 1024UL;
+
+static size_t const vertex_lanes = sizeof(Vertex) / sizeof(uint32_t);
+
+static_assert(std::is_trivially_copyable_v<Vertex>);
+static_assert(sizeof(Vertex) % sizeof(uint32_t) == 0);
+
+struct EncodedHeader {
+    uint64_t vertex_block_count{};
+    uint64_t index_block_count{};
+};
+
+// the table of blocks follows the header, `offset` is relative to the end of the table
+struct EncodedBlock {
+    uint64_t first{};
+    uint64_t count{};
+    uint64_t offset{};
+    uint64_t size{};
+};
+
+static void filter_vertices(std::span<Vertex const> vertices, std::span<std::byte> planes)
+{
+    auto const count = vertices.size();
+    std::array<uint32_t, vertex_lanes> previous{};
+    for (size_t v = 0; v < count; ++v) {
+        std::array<uint32_t, vertex_lanes> lanes{};
+        std::memcpy(lanes.data(), &vertices[v], sizeof(Vertex));
+        for (size_t lane = 0; lane < vertex_lanes; ++lane) {
+            auto const delta = lanes[lane] - previous[lane];
+            for (size_t b = 0; b < sizeof(uint32_t); ++b) {
+                planes[(lane * sizeof(uint32_t) + b) * count + v] = static_cast<std::byte>(delta >> (8 * b));
+            }
+        }
+        previous = lanes;
+    }
+}
+
+static void unfilter_vertices(std::span<std::byte const> planes, std::span<Vertex> vertices)
+{
+    auto const count = vertices.size();
+    std::vector<uint32_t> words(count * vertex_lanes);
+
+    // planes are read sequentially, four at a time, and only the running
+    // sum of a lane depends on the previous vertex
+    for (size_t lane = 0; lane < vertex_lanes; ++lane) {
+        auto const* p0 = planes.data() + (lane * sizeof(uint32_t) + 0) * count;
+        auto const* p1 = planes.data() + (lane * sizeof(uint32_t) + 1) * count;
+        auto const* p2 = planes.data() + (lane * sizeof(uint32_t) + 2) * count;
+        auto const* p3 = planes.data() + (lane * sizeof(uint32_t) + 3) * count;
+        uint32_t value = 0;
+        for (size_t v = 0; v < count; ++v) {
+            value += static_cast<uint32_t>(p0[v])
+              | static_cast<uint32_t>(p1[v]) << 8
+              | static_cast<uint32_t>(p2[v]) << 16
+              | static_cast<uint32_t>(p3[v]) << 24;
+            words[v * vertex_lanes + lane] = value;
+        }
+    }
+
+    std::memcpy(static_cast<void*>(vertices.data()), words.data(), vertices.size_bytes());
+}
+
+static void filter_indices(std::span<uint32_t const> indices, std::span<std::byte> planes)
+{
+    auto const count = indices.size();
+    uint32_t previous = 0;
+    for (size_t i = 0; i < count; ++i) {
+        auto const delta = indices[i] - previous;
+        auto const zigzag = (delta << 1) ^ (0U - (delta >> 31));
+        for (size_t b = 0; b < sizeof(uint32_t); ++b) {
+            planes[b * count + i] = static_cast<std::byte>(zigzag >> (8 * b));
+        }
+        previous = indices[i];
+    }
+}
+
+static void unfilter_indices(std::span<std::byte const> planes, std::span<uint32_t> indices)
+{
+    auto const count = indices.size();
+    auto const* p0 = planes.data();
+    auto const* p1 = planes.data() + count;
+    auto const* p2 = planes.data() + 2 * count;
+    auto const* p3 = planes.data() + 3 * count;
+    uint32_t value = 0;
+    for (size_t i = 0; i < count; ++i) {
+        auto const zigzag = static_cast<uint32_t>(p0[i])
+          | static_cast<uint32_t>(p1[i]) << 8
+          | static_cast<uint32_t>(p2[i]) << 16
+          | static_cast<uint32_t>(p3[i]) << 24;
+        value += (zigzag >> 1) ^ (0U - (zigzag & 1U));
+        indices[i] = value;
+    }
+}
+
+static std::vector<std::byte> deflate_planes(std::vector<std::byte> const& planes)
+{
+    auto size = compressBound(planes.size());
+    std::vector<std::byte> res(size);
+    auto const status = compress2(
+      reinterpret_cast<Bytef*>(res.data()), &size,
+      reinterpret_cast<Bytef const*>(planes.data()), planes.size(),
+      Z_DEFAULT_COMPRESSION);
+    if (status != Z_OK) {
+        throw std::runtime_error(fmt::format("could not compress mesh data: {}", zError(status)));
+    }
+    res.resize(size);
+    return res;
+}
+
+static void inflate_planes(std::span<std::byte const> encoded, std::vector<std::byte>& planes)
+{
+    auto size = static_cast<uLongf>(planes.size());
+    auto const status = uncompress(
+      reinterpret_cast<Bytef*>(planes.data()), &size,
+      reinterpret_cast<Bytef const*>(encoded.data()), encoded.size());
+    if (status != Z_OK || size != planes.size()) {
+        throw std::runtime_error("corrupt mesh data");
+    }
+}
+
+static std::vector<EncodedBlock> split_into_blocks(size_t count, size_t block_size)
+{
+    std::vector<EncodedBlock> res{};
+    for (size_t first = 0; first < count; first += block_size) {
+        res.push_back({first, std::min(block_size, count - first), 0, 0});
+    }
+    return res;
+}
+
+std::vector<std::byte> encode_mesh_data(
+  std::span<Vertex const> vertices,
+  std::span<uint32_t const> indices,
+  size_t thread_count)
+{
+    auto blocks = split_into_blocks(vertices.size(), vertex_block_size);
+    auto const vertex_block_count = blocks.size();
+    auto const index_blocks = split_into_blocks(indices.size(), index_block_size);
+    blocks.insert(blocks.end(), index_blocks.cbegin(), index_blocks.cend());
+
+    std::vector<std::vector<std::byte>> encoded_blocks(blocks.size());
+    playground::parallel_for(blocks.size(), thread_count, 1, [&](size_t begin, size_t end) {
+        std::vector<std::byte> planes{};
+        for (size_t i = begin; i < end; ++i) {
+            auto const& block = blocks[i];
+            if (i < vertex_block_count) {
+                planes.resize(block.count * sizeof(Vertex));
+                filter_vertices(vertices.subspan(block.first, block.count), planes);
+            } else {
+                planes.resize(block.count * sizeof(uint32_t));
+                filter_indices(indices.subspan(block.first, block.count), planes);
+            }
+            encoded_blocks[i] = deflate_planes(planes);
+        }
+    });
+
+    uint64_t offset = 0;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        blocks[i].offset = offset;
+        blocks[i].size = encoded_blocks[i].size();
+        offset += blocks[i].size;
+    }
+
+    EncodedHeader const header{vertex_block_count, blocks.size() - vertex_block_count};
+    auto const table = std::as_bytes(std::span{blocks});
+
+    std::vector<std::byte> res(sizeof(header) + table.size() + offset);
+    std::memcpy(res.data(), &header, sizeof(header));
+    std::memcpy(res.data() + sizeof(header), table.data(), table.size());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        std::memcpy(res.data() + sizeof(header) + table.size() + blocks[i].offset, encoded_blocks[i].data(), encoded_blocks[i].size());
+    }
+
+    return res;
+}
+
+void decode_mesh_data(
+  std::span<std::byte const> encoded,
+  std::span<Vertex> vertices,
+  std::span<uint32_t> indices,
+  size_t thread_count)
+{
+    // the encoded data is not necessarily aligned for 64-bit reads
+    EncodedHeader header{};
+    if (encoded.size() < sizeof(header)) {
+        throw std::runtime_error("corrupt mesh data");
+    }
+    std::memcpy(&header, encoded.data(), sizeof(header));
+
+    auto const block_count = header.vertex_block_count + header.index_block_count;
+    if (block_count > (encoded.size() - sizeof(header)) / sizeof(EncodedBlock)) {
+        throw std::runtime_error("corrupt mesh data");
+    }
+    std::vector<EncodedBlock> blocks(block_count);
+    std::memcpy(blocks.data(), encoded.data() + sizeof(header), block_count * sizeof(EncodedBlock));
+    auto const data = encoded.subspan(sizeof(header) + block_count * sizeof(EncodedBlock));
+
+    // blocks must cover the destinations exactly, so blocks never overlap
+    uint64_t next_vertex = 0;
+    uint64_t next_index = 0;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        auto& next = i < header.vertex_block_count ? next_vertex : next_index;
+        auto const count = i < header.vertex_block_count ? vertices.size() : indices.size();
+        if (blocks[i].first != next || blocks[i].count > count - next
+          || blocks[i].offset > data.size() || blocks[i].size > data.size() - blocks[i].offset) {
+            throw std::runtime_error("corrupt mesh data");
+        }
+        next += blocks[i].count;
+    }
+    if (next_vertex != vertices.size() || next_index != indices.size()) {
+        throw std::runtime_error("corrupt mesh data");
+    }
+
+    playground::parallel_for(blocks.size(), thread_count, 1, [&](size_t begin, size_t end) {
+        std::vector<std::byte> planes{};
+        for (size_t i = begin; i < end; ++i) {
+            auto const& block = blocks[i];
+            auto const block_data = data.subspan(block.offset, block.size);
+            if (i < header.vertex_block_count) {
+                planes.resize(block.count * sizeof(Vertex));
+                inflate_planes(block_data, planes);
+                unfilter_vertices(planes, vertices.subspan(block.first, block.count));
+            } else {
+                planes.resize(block.count * sizeof(uint32_t));
+                inflate_planes(block_data, planes);
+                unfilter_indices(planes, indices.subspan(block.first, block.count));
+            }
+        }
+    });
+}
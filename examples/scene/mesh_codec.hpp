@@ -0,0 +1,43 @@
+#ifndef PLAYGROUND_MESH_CODEC_HPP
+#define PLAYGROUND_MESH_CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "../../playground/parallel_for.hpp"
+
+// the load options of `vertex.hpp` refer to the compression
+struct Vertex;
+
+enum class MeshCompression {
+    None, // vertices and indices are stored as they are laid out in memory
+    Deflate, // filtered vertices and indices are compressed with deflate
+};
+
+/*******************************************************************************
+ * lossless encoding of vertices and indices for storage on disk.
+ * Both are split into independent blocks, so blocks are encoded and decoded
+ * concurrently. Before deflate, every 32-bit lane of a vertex is delta coded
+ * against the previous vertex and indices are delta and zigzag coded, then
+ * the values are transposed into byte planes: neighbouring vertices after
+ * `optimize_vertex_fetch` differ mostly in the low bytes, so the high byte
+ * planes consist of long runs
+ ******************************************************************************/
+std::vector<std::byte> encode_mesh_data(
+  std::span<Vertex const> vertices,
+  std::span<uint32_t const> indices,
+  size_t thread_count = playground::default_thread_count());
+
+/*******************************************************************************
+ * decodes data of `encode_mesh_data` into the given ranges, which must have
+ * exactly the number of encoded elements. Throws if the data is corrupt
+ ******************************************************************************/
+void decode_mesh_data(
+  std::span<std::byte const> encoded,
+  std::span<Vertex> vertices,
+  std::span<uint32_t> indices,
+  size_t thread_count = playground::default_thread_count());
+
+#endif // PLAYGROUND_MESH_CODEC_HPP
@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+#include "../../playground/mapped_file.hpp"
+#include "mesh_converter.hpp"
+#include "wavefront.hpp"
+
+// a parsed block takes several times the size of its text,
+// and the vertex and index buffers of the emission take their share too
+static size_t const memory_limit_parts = 8;
+static size_t const min_block_size = 64UL * 1024UL;
+
+/*******************************************************************************
+ * a file next to the source, removed when the conversion finishes or fails;
+ * temporary directories are often in memory, which defeats the purpose
+ ******************************************************************************/
+class TemporaryFile {
+public:
+    explicit TemporaryFile(std::string path) :
+      path_{std::move(path)} {}
+
+    TemporaryFile(TemporaryFile const&) = delete;
+    TemporaryFile(TemporaryFile&&) = delete;
+    TemporaryFile& operator=(TemporaryFile const&) = delete;
+    TemporaryFile& operator=(TemporaryFile&&) = delete;
+
+    ~TemporaryFile()
+    {
+        std::error_code ignored{};
+        std::filesystem::remove(path_, ignored);
+    }
+
+    [[nodiscard]] std::string const& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+template <class T>
+static void append(std::ofstream& out, std::vector<T> const& values)
+{
+    out.write(reinterpret_cast<char const*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+template <class T>
+static std::span<T const> as_span(playground::MappedFile const& file)
+{
+    return {reinterpret_cast<T const*>(file.bytes().data()), file.size() / sizeof(T)};
+}
+
+static uint32_t checked_index(uint32_t index, size_t count)
+{
+    if (index >= count) {
+        throw std::runtime_error("index out of range");
+    }
+    return index;
+}
+
+void convert_wavefront_out_of_core(
+  std::string const& file_path,
+  MeshSink& sink,
+  size_t memory_limit,
+  NormalWeighting weighting)
+{
+    auto const start = std::chrono::steady_clock::now();
+    auto const block_size = std::max(memory_limit / memory_limit_parts, min_block_size);
+
+    playground::MappedFile const source{file_path};
+
+    TemporaryFile const positions_path{file_path + ".positions.tmp"};
+    TemporaryFile const uvs_path{file_path + ".uvs.tmp"};
+    TemporaryFile const normals_path{file_path + ".normals.tmp"};
+    TemporaryFile const vertices_path{file_path + ".vertices.tmp"};
+
+    // 1. counts and bounds, attributes are spilled to disk in the order of the file
+    size_t position_count = 0;
+    size_t triangle_count = 0;
+    bool has_authored_normals = true;
+    glm::vec3 min_p{std::numeric_limits<float>::max()};
+    glm::vec3 max_p{std::numeric_limits<float>::lowest()};
+    {
+        std::ofstream positions_out{positions_path.path(), std::ios::binary | std::ios::trunc};
+        std::ofstream uvs_out{uvs_path.path(), std::ios::binary | std::ios::trunc};
+        std::ofstream normals_out{normals_path.path(), std::ios::binary | std::ios::trunc};
+        for (auto* out : {&positions_out, &uvs_out, &normals_out}) {
+            if (!*out) {
+                throw std::runtime_error(fmt::format("could not create temporary files next to `{}`", file_path));
+            }
+            out->exceptions(std::ofstream::failbit | std::ofstream::badbit);
+        }
+
+        parse_wavefront_blocks(source.view(), block_size, [&](WavefrontMesh const& block) {
+            append(positions_out, block.positions);
+            append(uvs_out, block.uvs);
+            append(normals_out, block.normals);
+
+            for (auto const& p : block.positions) {
+                min_p = glm::min(min_p, p);
+                max_p = glm::max(max_p, p);
+            }
+            position_count += block.positions.size();
+            triangle_count += block.position_indices.size();
+
+            has_authored_normals = has_authored_normals
+              && std::all_of(block.normal_indices.cbegin(), block.normal_indices.cend(), [](glm::uvec3 const& polygon) {
+                     return polygon.x != wavefront_no_index && polygon.y != wavefront_no_index && polygon.z != wavefront_no_index;
+                 })
+              && block.normal_indices.size() == block.position_indices.size();
+        });
+    }
+    has_authored_normals = has_authored_normals && triangle_count > 0;
+
+    if (position_count > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("the model has too many vertices for 32-bit indices");
+    }
+
+    auto const [offset, scale] = place_model(min_p, max_p);
+    MeshLayout layout{
+      position_count,
+      triangle_count * 3,
+      {{0, triangle_count * 3, 0.0F}},
+      glm::min((min_p - offset) * scale, (max_p - offset) * scale),
+      glm::max((min_p - offset) * scale, (max_p - offset) * scale)};
+    sink.begin(layout);
+
+    playground::MappedFile const positions_file{positions_path.path(), playground::MappedAccess::Normal};
+    playground::MappedFile const uvs_file{uvs_path.path(), playground::MappedAccess::Normal};
+    playground::MappedFile const normals_file{normals_path.path(), playground::MappedAccess::Normal};
+    auto const positions = as_span<glm::vec3>(positions_file);
+    auto const uvs = as_span<glm::vec2>(uvs_file);
+    auto const normals = as_span<glm::vec3>(normals_file);
+
+    // vertices are updated in random order while the faces are streamed,
+    // a NaN uv marks a vertex no corner has assigned a uv to yet
+    playground::WritableMappedFile const vertices_file{vertices_path.path(), position_count * sizeof(Vertex)};
+    auto* const vertices = reinterpret_cast<Vertex*>(vertices_file.bytes().data());
+    for (size_t v = 0; v < position_count; ++v) {
+        vertices[v] = {positions[v], glm::vec3{0.0F}, glm::vec2{std::numeric_limits<float>::quiet_NaN()}};
+    }
+
+    // 2. indices are emitted block by block, normals and uvs gathered into the vertices
+    std::vector<uint32_t> indices{};
+    size_t first_index = 0;
+    parse_wavefront_blocks(source.view(), block_size, [&](WavefrontMesh const& block) {
+        indices.clear();
+        for (size_t polygon = 0; polygon < block.position_indices.size(); ++polygon) {
+            auto const& idx = block.position_indices[polygon];
+            for (glm::length_t i{}; i < idx.length(); ++i) {
+                indices.push_back(checked_index(idx[i], position_count));
+            }
+
+            if (!has_authored_normals) {
+                auto const polygon_normal = calculate_polygon_normal(
+                  positions[idx[0]], positions[idx[1]], positions[idx[2]], weighting);
+                for (glm::length_t i{}; i < idx.length(); ++i) {
+                    vertices[idx[i]].normal += polygon_normal.normal * polygon_normal.weights[static_cast<size_t>(i)];
+                }
+            }
+
+            for (glm::length_t i{}; i < idx.length(); ++i) {
+                auto& vertex = vertices[idx[i]];
+                if (has_authored_normals && vertex.normal == glm::vec3{0.0F}) {
+                    vertex.normal = glm::normalize(normals[checked_index(block.normal_indices[polygon][i], normals.size())]);
+                }
+                if (!block.uv_indices.empty() && block.uv_indices[polygon][i] != wavefront_no_index && std::isnan(vertex.uv.x)) {
+                    vertex.uv = uvs[checked_index(block.uv_indices[polygon][i], uvs.size())];
+                }
+            }
+        }
+
+        sink.write_indices(first_index, indices);
+        first_index += indices.size();
+    });
+    indices = {};
+
+    // 3. vertices are finalized and emitted in chunks
+    auto const chunk_size = std::max(memory_limit / memory_limit_parts / sizeof(Vertex), 1UL);
+    std::vector<Vertex> chunk{};
+    chunk.reserve(std::min(chunk_size, position_count));
+    for (size_t first_vertex = 0; first_vertex < position_count; first_vertex += chunk.size()) {
+        chunk.clear();
+        for (size_t v = first_vertex; v < std::min(first_vertex + chunk_size, position_count); ++v) {
+            auto vertex = vertices[v];
+            vertex.position = (vertex.position - offset) * scale;
+            auto const length = glm::length(vertex.normal);
+            vertex.normal = length > 0.0F ? vertex.normal / length : vertex.normal;
+            vertex.uv = std::isnan(vertex.uv.x) ? glm::vec2{0.0F} : vertex.uv;
+            chunk.push_back(vertex);
+        }
+        sink.write_vertices(first_vertex, chunk);
+    }
+
+    sink.end();
+
+    std::chrono::duration<double> const time = std::chrono::steady_clock::now() - start;
+    spdlog::info("converted `{}` out of core in {:.1f} s: {} vertices, {} triangles",
+      file_path, time.count(), position_count, triangle_count);
+}
@@ -0,0 +1,65 @@
+#ifndef PLAYGROUND_MESH_CONVERTER_HPP
+#define PLAYGROUND_MESH_CONVERTER_HPP
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "normals.hpp"
+#include "vertex.hpp"
+
+/*******************************************************************************
+ * sizes and bounds of a model, known before any of its data is written
+ ******************************************************************************/
+struct MeshLayout {
+    size_t vertex_count{};
+    size_t index_count{};
+    std::vector<MeshLod> lods{};
+    glm::vec3 min_bound{0.0F};
+    glm::vec3 max_bound{0.0F};
+};
+
+/*******************************************************************************
+ * destination of a model written chunk by chunk, e.g. a file or GPU buffers.
+ * `begin` is called first, then vertices and indices are written in chunks
+ * at the given positions in any order, `end` is called once everything is written
+ ******************************************************************************/
+class MeshSink {
+public:
+    MeshSink() = default;
+    MeshSink(MeshSink const&) = delete;
+    MeshSink(MeshSink&&) = delete;
+    MeshSink& operator=(MeshSink const&) = delete;
+    MeshSink& operator=(MeshSink&&) = delete;
+    virtual ~MeshSink() = default;
+
+    virtual void begin(MeshLayout const& layout) = 0;
+
+    virtual void write_vertices(size_t first_vertex, std::span<Vertex const> vertices) = 0;
+
+    virtual void write_indices(size_t first_index, std::span<uint32_t const> indices) = 0;
+
+    virtual void end() = 0;
+};
+
+/*******************************************************************************
+ * converts a wavefront file into a model without holding the model in memory:
+ * the first pass collects counts and bounds and spills the attributes into
+ * temporary files, the second pass emits the indices and accumulates normals
+ * in a memory-mapped vertex file, which is then emitted in chunks.
+ * Buffers of the conversion stay within `memory_limit` bytes, mapped files
+ * live in the page cache and are written back under memory pressure.
+ *
+ * There is one vertex per position of the file, so vertices are not welded,
+ * optimized or simplified; a position takes the uv and the authored normal of
+ * the first polygon corner that references it. Normals are generated, as with
+ * `calculate_vertex_normals`, unless every corner has an authored one
+ ******************************************************************************/
+void convert_wavefront_out_of_core(
+  std::string const& file_path,
+  MeshSink& sink,
+  size_t memory_limit,
+  NormalWeighting weighting);
+
+#endif // PLAYGROUND_MESH_CONVERTER_HPP
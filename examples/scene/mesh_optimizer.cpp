@@ -0,0 +1,158 @@
+#include <limits>
+
+#include "mesh_optimizer.hpp"
+
+static uint32_t const no_vertex = std::numeric_limits<uint32_t>::max();
+
+VertexCacheStats analyze_vertex_cache(std::vector<uint32_t> const& indices, size_t vertex_count, size_t cache_size)
+{
+    // a vertex is in the FIFO cache if less than `cache_size` vertices
+    // were pushed since it has been pushed itself
+    std::vector<size_t> cache_time(vertex_count);
+    std::vector<bool> referenced(vertex_count);
+    size_t timestamp = cache_size + 1;
+    size_t misses = 0;
+    size_t referenced_count = 0;
+
+    for (auto v : indices) {
+        if (timestamp - cache_time[v] > cache_size) {
+            cache_time[v] = timestamp++;
+            ++misses;
+        }
+        if (!referenced[v]) {
+            referenced[v] = true;
+            ++referenced_count;
+        }
+    }
+
+    VertexCacheStats res{};
+    if (!indices.empty()) {
+        res.acmr = static_cast<double>(misses) / static_cast<double>(indices.size() / 3);
+        res.atvr = static_cast<double>(misses) / static_cast<double>(referenced_count);
+    }
+    return res;
+}
+
+void optimize_vertex_cache(std::vector<uint32_t>& indices, size_t vertex_count, size_t cache_size)
+{
+    auto const triangle_count = indices.size() / 3;
+    if (triangle_count == 0) {
+        return;
+    }
+
+    // vertex-to-triangle adjacency, triangles adjacent to vertex `v` are
+    // `adjacent[offsets[v]]` to `adjacent[offsets[v + 1] - 1]`
+    std::vector<uint32_t> offsets(vertex_count + 1);
+    std::vector<uint32_t> adjacent(indices.size());
+    for (auto v : indices) {
+        ++offsets[v + 1];
+    }
+    for (size_t v = 0; v < vertex_count; ++v) {
+        offsets[v + 1] += offsets[v];
+    }
+
+    // number of not yet emitted triangles using the vertex
+    std::vector<uint32_t> live(vertex_count);
+    {
+        std::vector<uint32_t> cursor(offsets.cbegin(), offsets.cend() - 1);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            auto const v = indices[i];
+            adjacent[cursor[v]++] = static_cast<uint32_t>(i / 3);
+            ++live[v];
+        }
+    }
+
+    std::vector<size_t> cache_time(vertex_count);
+    std::vector<bool> emitted(triangle_count);
+    std::vector<uint32_t> dead_end{}; // recently used vertices, the fallback when the fan runs out
+    std::vector<uint32_t> candidates{};
+
+    std::vector<uint32_t> res{};
+    res.reserve(indices.size());
+
+    size_t timestamp = cache_size + 1;
+    size_t next_unused = 0; // vertices below it have no live triangles left
+    uint32_t fan = indices[0];
+
+    while (fan != no_vertex) {
+        candidates.clear();
+
+        // emit all remaining triangles around the fanning vertex
+        for (auto i = offsets[fan]; i < offsets[fan + 1]; ++i) {
+            auto const triangle = adjacent[i];
+            if (emitted[triangle]) {
+                continue;
+            }
+            emitted[triangle] = true;
+
+            for (size_t corner = 0; corner < 3; ++corner) {
+                auto const v = indices[triangle * 3 + corner];
+                res.push_back(v);
+                dead_end.push_back(v);
+                candidates.push_back(v);
+                --live[v];
+                if (timestamp - cache_time[v] > cache_size) {
+                    cache_time[v] = timestamp++;
+                }
+            }
+        }
+
+        // the next fan is the oldest candidate which will still be
+        // in the cache after all of its triangles are emitted
+        fan = no_vertex;
+        size_t best_priority = 0;
+        for (auto v : candidates) {
+            if (live[v] == 0) {
+                continue;
+            }
+            size_t priority = 1;
+            auto const age = timestamp - cache_time[v];
+            if (age + 2 * live[v] <= cache_size) {
+                priority += age;
+            }
+            if (priority > best_priority) {
+                best_priority = priority;
+                fan = v;
+            }
+        }
+
+        // otherwise a recently used vertex, otherwise any vertex with triangles left
+        while (fan == no_vertex && !dead_end.empty()) {
+            auto const v = dead_end.back();
+            dead_end.pop_back();
+            if (live[v] > 0) {
+                fan = v;
+            }
+        }
+        for (; fan == no_vertex && next_unused < vertex_count; ++next_unused) {
+            if (live[next_unused] > 0) {
+                fan = static_cast<uint32_t>(next_unused);
+            }
+        }
+    }
+
+    indices = std::move(res);
+}
+
+void optimize_vertex_fetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+    std::vector<uint32_t> remap(vertices.size(), no_vertex);
+    std::vector<Vertex> res{};
+    res.reserve(vertices.size());
+
+    for (auto& v : indices) {
+        if (remap[v] == no_vertex) {
+            remap[v] = static_cast<uint32_t>(res.size());
+            res.push_back(vertices[v]);
+        }
+        v = remap[v];
+    }
+
+    for (size_t v = 0; v < vertices.size(); ++v) {
+        if (remap[v] == no_vertex) {
+            res.push_back(vertices[v]);
+        }
+    }
+
+    vertices = std::move(res);
+}
@@ -0,0 +1,47 @@
+#ifndef PLAYGROUND_MESH_OPTIMIZER_HPP
+#define PLAYGROUND_MESH_OPTIMIZER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "vertex.hpp"
+
+// number of entries of the simulated post-transform vertex cache
+inline constexpr size_t default_vertex_cache_size = 16;
+
+/*******************************************************************************
+ * efficiency of a triangle order on a FIFO post-transform vertex cache:
+ * ACMR is the average number of vertex shader invocations per triangle
+ * (0.5 is the ideal for large regular meshes, 3 is the worst case),
+ * ATVR is the number of invocations per referenced vertex (1 is the ideal)
+ ******************************************************************************/
+struct VertexCacheStats {
+    double acmr{};
+    double atvr{};
+};
+
+VertexCacheStats analyze_vertex_cache(
+  std::vector<uint32_t> const& indices,
+  size_t vertex_count,
+  size_t cache_size = default_vertex_cache_size);
+
+/*******************************************************************************
+ * reorders triangles, so consecutive triangles share as many vertices as
+ * possible while they are still in the cache (Tipsify, Sander et al. 2007).
+ * The algorithm runs in linear time, triangles themselves and their winding
+ * stay the same, only their order changes
+ ******************************************************************************/
+void optimize_vertex_cache(
+  std::vector<uint32_t>& indices,
+  size_t vertex_count,
+  size_t cache_size = default_vertex_cache_size);
+
+/*******************************************************************************
+ * reorders vertices in the order of their first use by the indices,
+ * so the vertex fetch reads the VBO mostly sequentially.
+ * Run it after `optimize_vertex_cache`, unreferenced vertices are moved
+ * to the end of the buffer
+ ******************************************************************************/
+void optimize_vertex_fetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+#endif // PLAYGROUND_MESH_OPTIMIZER_HPP
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "meshlets.hpp"
+
+/*******************************************************************************
+ * computes the bounding sphere and the normal cone of the meshlet's triangles
+ ******************************************************************************/
+static void calculate_bounds(Meshlet& meshlet, std::span<Vertex const> vertices, std::span<uint32_t const> indices)
+{
+    auto const triangles = indices.subspan(meshlet.index_offset, meshlet.index_count);
+
+    glm::vec3 min_bound{std::numeric_limits<float>::max()};
+    glm::vec3 max_bound{std::numeric_limits<float>::lowest()};
+    for (auto i : triangles) {
+        min_bound = glm::min(min_bound, vertices[i].position);
+        max_bound = glm::max(max_bound, vertices[i].position);
+    }
+
+    meshlet.center = (min_bound + max_bound) * 0.5F;
+    meshlet.radius = 0.0F;
+    for (auto i : triangles) {
+        meshlet.radius = std::max(meshlet.radius, glm::length(vertices[i].position - meshlet.center));
+    }
+
+    std::vector<glm::vec3> normals{};
+    normals.reserve(triangles.size() / 3);
+    glm::vec3 normal_sum{0.0F};
+    for (size_t i = 0; i + 2 < triangles.size(); i += 3) {
+        auto const& a = vertices[triangles[i]].position;
+        auto const& b = vertices[triangles[i + 1]].position;
+        auto const& c = vertices[triangles[i + 2]].position;
+        auto const cross = glm::cross(b - a, c - a);
+        auto const length = glm::length(cross);
+        if (length > 0.0F) {
+            normals.push_back(cross / length);
+            normal_sum += normals.back();
+        }
+    }
+
+    // the cone can not cull when triangles face opposite directions
+    auto const sum_length = glm::length(normal_sum);
+    if (sum_length == 0.0F) {
+        return;
+    }
+    meshlet.cone_axis = normal_sum / sum_length;
+
+    float min_dot = 1.0F;
+    for (auto const& normal : normals) {
+        min_dot = std::min(min_dot, glm::dot(meshlet.cone_axis, normal));
+    }
+    if (min_dot <= 0.0F) {
+        return;
+    }
+
+    // sine of the cone's half-angle, the complement of the angle between the axis and the widest normal
+    meshlet.cone_cutoff = std::sqrt(1.0F - min_dot * min_dot);
+}
+
+std::vector<Meshlet> build_meshlets(std::span<Vertex const> vertices, std::span<uint32_t const> indices)
+{
+    std::vector<Meshlet> res{};
+
+    // a vertex belongs to the current meshlet when its mark equals the meshlet number
+    std::vector<size_t> marks(vertices.size(), std::numeric_limits<size_t>::max());
+    Meshlet current{};
+    size_t vertex_count = 0;
+
+    auto finish = [&]() {
+        calculate_bounds(current, vertices, indices);
+        res.push_back(current);
+        current = Meshlet{};
+        current.index_offset = res.back().index_offset + res.back().index_count;
+        vertex_count = 0;
+    };
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        std::array<uint32_t, 3> const corners{indices[i], indices[i + 1], indices[i + 2]};
+        size_t new_vertices = 0;
+        for (auto it = corners.cbegin(); it != corners.cend(); ++it) {
+            if (marks[*it] != res.size() && std::find(corners.cbegin(), it, *it) == it) {
+                ++new_vertices;
+            }
+        }
+
+        if (current.index_count / 3 == max_meshlet_triangles || vertex_count + new_vertices > max_meshlet_vertices) {
+            finish();
+        }
+
+        for (auto v : corners) {
+            if (marks[v] != res.size()) {
+                marks[v] = res.size();
+                ++vertex_count;
+            }
+        }
+        current.index_count += 3;
+    }
+
+    if (current.index_count > 0) {
+        finish();
+    }
+
+    return res;
+}
+
+Frustum extract_frustum(glm::mat4 const& view_proj)
+{
+    // rows of the matrix, glm matrices are column-major
+    std::array<glm::vec4, 4> rows{};
+    for (glm::length_t row = 0; row < 4; ++row) {
+        rows[static_cast<size_t>(row)] = {view_proj[0][row], view_proj[1][row], view_proj[2][row], view_proj[3][row]};
+    }
+
+    Frustum res{
+      {rows[3] + rows[0], rows[3] - rows[0],
+       rows[3] + rows[1], rows[3] - rows[1],
+       rows[3] + rows[2], rows[3] - rows[2]}};
+
+    for (auto& plane : res.planes) {
+        plane /= glm::length(glm::vec3{plane});
+    }
+    return res;
+}
+
+bool is_meshlet_visible(Meshlet const& meshlet, Frustum const& frustum, glm::vec3 const& camera_position)
+{
+    for (auto const& plane : frustum.planes) {
+        if (glm::dot(glm::vec3{plane}, meshlet.center) + plane.w < -meshlet.radius) {
+            return false;
+        }
+    }
+
+    // every triangle faces away when the whole bounding sphere is inside of the
+    // cone of directions from which all triangles are seen from the back
+    auto const to_center = meshlet.center - camera_position;
+    return meshlet.cone_cutoff >= 1.0F
+      || glm::dot(to_center, meshlet.cone_axis) < meshlet.cone_cutoff * glm::length(to_center) + meshlet.radius;
+}
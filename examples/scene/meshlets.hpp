@@ -0,0 +1,59 @@
+#ifndef PLAYGROUND_MESHLETS_HPP
+#define PLAYGROUND_MESHLETS_HPP
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "vertex.hpp"
+
+// limits of a cluster, they match the common mesh shader limits
+inline constexpr size_t max_meshlet_vertices = 64;
+inline constexpr size_t max_meshlet_triangles = 124;
+
+/*******************************************************************************
+ * a cluster of adjacent triangles, a contiguous range of the mesh indices.
+ * Normals of all triangles deviate from `cone_axis` by at most the angle
+ * whose sine is `cone_cutoff`; a cutoff of 1 means the triangles face
+ * too many directions to be ever culled as backfacing
+ ******************************************************************************/
+struct Meshlet {
+    size_t index_offset{};
+    size_t index_count{};
+    glm::vec3 center{0.0F};
+    float radius{};
+    glm::vec3 cone_axis{0.0F};
+    float cone_cutoff{1.0F};
+};
+
+/*******************************************************************************
+ * planes of a view frustum pointing inside, `xyz` is a unit normal
+ ******************************************************************************/
+struct Frustum {
+    std::array<glm::vec4, 6> planes{};
+};
+
+/*******************************************************************************
+ * splits the triangles into meshlets of at most `max_meshlet_vertices` unique
+ * vertices and `max_meshlet_triangles` triangles.
+ * Triangles are taken in their order without reordering the indices, so
+ * meshlets are tight when the indices are optimized for the vertex cache
+ ******************************************************************************/
+std::vector<Meshlet> build_meshlets(std::span<Vertex const> vertices, std::span<uint32_t const> indices);
+
+/*******************************************************************************
+ * extracts the frustum planes from a projection * view matrix,
+ * planes are in the space the matrix transforms from
+ ******************************************************************************/
+Frustum extract_frustum(glm::mat4 const& view_proj);
+
+/*******************************************************************************
+ * false if the meshlet is entirely outside of the frustum or all of its
+ * triangles face away from the camera
+ ******************************************************************************/
+bool is_meshlet_visible(Meshlet const& meshlet, Frustum const& frustum, glm::vec3 const& camera_position);
+
+#endif // PLAYGROUND_MESHLETS_HPP
@@ -0,0 +1,161 @@
+#include <cmath>
+#include <cstdint>
+
+#include "normals.hpp"
+
+// below these sizes spawning threads costs more than the work itself
+static size_t const min_polygons_per_thread = 16UL * 1024UL;
+static size_t const min_vertices_per_thread = 16UL * 1024UL;
+
+/*******************************************************************************
+ * structure of arrays, so the final pass over the components vectorizes
+ ******************************************************************************/
+struct Vec3Array {
+    std::vector<float> x{};
+    std::vector<float> y{};
+    std::vector<float> z{};
+
+    explicit Vec3Array(size_t size) :
+      x(size), y(size), z(size) {}
+};
+
+/*******************************************************************************
+ * compressed sparse rows of the vertex-to-polygon adjacency: corners adjacent
+ * to vertex `v` are `corners[offsets[v]]` to `corners[offsets[v + 1] - 1]`,
+ * a corner is `polygon * 3 + corner index within the polygon`.
+ * Corners of every vertex are sorted by polygon, so the sums below are
+ * always accumulated in the same order
+ ******************************************************************************/
+struct Adjacency {
+    std::vector<uint32_t> offsets{};
+    std::vector<uint32_t> corners{};
+};
+
+static Adjacency build_adjacency(size_t vertex_count, std::vector<glm::uvec3> const& indices)
+{
+    Adjacency res{};
+    res.offsets.resize(vertex_count + 1);
+    res.corners.resize(indices.size() * 3);
+
+    for (auto const& polygon : indices) {
+        for (glm::length_t i{}; i < polygon.length(); ++i) {
+            ++res.offsets[polygon[i] + 1];
+        }
+    }
+
+    for (size_t v = 0; v < vertex_count; ++v) {
+        res.offsets[v + 1] += res.offsets[v];
+    }
+
+    std::vector<uint32_t> cursor(res.offsets.cbegin(), res.offsets.cend() - 1);
+    for (size_t p = 0; p < indices.size(); ++p) {
+        for (glm::length_t i{}; i < indices[p].length(); ++i) {
+            res.corners[cursor[indices[p][i]]++] = static_cast<uint32_t>(p * 3 + static_cast<size_t>(i));
+        }
+    }
+
+    return res;
+}
+
+static float corner_angle(glm::vec3 const& corner, glm::vec3 const& a, glm::vec3 const& b)
+{
+    auto const u = a - corner;
+    auto const v = b - corner;
+    // atan2 of |u x v| and u . v is accurate for both small and obtuse angles
+    return std::atan2(glm::length(glm::cross(u, v)), glm::dot(u, v));
+}
+
+PolygonNormal calculate_polygon_normal(glm::vec3 const& a, glm::vec3 const& b, glm::vec3 const& c, NormalWeighting weighting)
+{
+    auto const cross = glm::cross(b - a, c - a);
+    auto const double_area = glm::length(cross);
+
+    // degenerate polygons have no direction and do not contribute
+    PolygonNormal res{};
+    if (double_area == 0.0F) {
+        return res;
+    }
+    res.normal = cross / double_area;
+
+    switch (weighting) {
+    case NormalWeighting::Uniform:
+        res.weights = {1.0F, 1.0F, 1.0F};
+        break;
+    case NormalWeighting::Area:
+        res.weights = {double_area, double_area, double_area};
+        break;
+    case NormalWeighting::Angle:
+        res.weights = {corner_angle(a, b, c), corner_angle(b, c, a), corner_angle(c, a, b)};
+        break;
+    }
+    return res;
+}
+
+std::vector<glm::vec3> calculate_vertex_normals(
+  std::vector<glm::vec3> const& vertices,
+  std::vector<glm::uvec3> const& indices,
+  NormalWeighting weighting,
+  size_t thread_count)
+{
+    // 1. unit normal of every polygon and the weight of every corner
+    Vec3Array polygon_normals{indices.size()};
+    std::vector<float> corner_weights(indices.size() * 3);
+
+    playground::parallel_for(indices.size(), thread_count, min_polygons_per_thread, [&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; ++p) {
+            auto const& a = vertices[indices[p][0]];
+            auto const& b = vertices[indices[p][1]];
+            auto const& c = vertices[indices[p][2]];
+
+            auto const polygon = calculate_polygon_normal(a, b, c, weighting);
+            polygon_normals.x[p] = polygon.normal.x;
+            polygon_normals.y[p] = polygon.normal.y;
+            polygon_normals.z[p] = polygon.normal.z;
+            corner_weights[p * 3 + 0] = polygon.weights[0];
+            corner_weights[p * 3 + 1] = polygon.weights[1];
+            corner_weights[p * 3 + 2] = polygon.weights[2];
+        }
+    });
+
+    // 2. every vertex gathers the weighted normals of its polygons,
+    // vertices are independent, so there are no write conflicts between threads
+    auto const adjacency = build_adjacency(vertices.size(), indices);
+    Vec3Array sums{vertices.size()};
+
+    playground::parallel_for(vertices.size(), thread_count, min_vertices_per_thread, [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            float x{}, y{}, z{};
+            for (auto i = adjacency.offsets[v]; i < adjacency.offsets[v + 1]; ++i) {
+                auto const corner = adjacency.corners[i];
+                auto const polygon = corner / 3;
+                auto const weight = corner_weights[corner];
+                x += weight * polygon_normals.x[polygon];
+                y += weight * polygon_normals.y[polygon];
+                z += weight * polygon_normals.z[polygon];
+            }
+            sums.x[v] = x;
+            sums.y[v] = y;
+            sums.z[v] = z;
+        }
+    });
+
+    // 3. normalize once at the end, a branch-free loop over plain arrays vectorizes
+    std::vector<glm::vec3> res(vertices.size());
+    playground::parallel_for(vertices.size(), thread_count, min_vertices_per_thread, [&](size_t begin, size_t end) {
+        float* const x = sums.x.data();
+        float* const y = sums.y.data();
+        float* const z = sums.z.data();
+        for (size_t v = begin; v < end; ++v) {
+            float const length_squared = x[v] * x[v] + y[v] * y[v] + z[v] * z[v];
+            float const inverse_length = length_squared > 0.0F ? 1.0F / std::sqrt(length_squared) : 0.0F;
+            x[v] *= inverse_length;
+            y[v] *= inverse_length;
+            z[v] *= inverse_length;
+        }
+        for (size_t v = begin; v < end; ++v) {
+            res[v] = {x[v], y[v], z[v]};
+        }
+    });
+
+    return res;
+}
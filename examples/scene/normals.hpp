@@ -0,0 +1,45 @@
+#ifndef PLAYGROUND_NORMALS_HPP
+#define PLAYGROUND_NORMALS_HPP
+
+#include <array>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../../playground/parallel_for.hpp"
+
+/*******************************************************************************
+ * how much every adjacent polygon contributes to the normal vector of a vertex
+ ******************************************************************************/
+enum class NormalWeighting {
+    Uniform, // every polygon counts the same
+    Area, // larger polygons count more
+    Angle, // polygons count by their angle at the vertex, independent of tessellation
+};
+
+/*******************************************************************************
+ * unit normal of a polygon and the weight of each of its corners in the
+ * normals of the corners' vertices; degenerate polygons have a zero normal
+ ******************************************************************************/
+struct PolygonNormal {
+    glm::vec3 normal{0.0F};
+    std::array<float, 3> weights{};
+};
+
+PolygonNormal calculate_polygon_normal(glm::vec3 const& a, glm::vec3 const& b, glm::vec3 const& c, NormalWeighting weighting);
+
+/*******************************************************************************
+ * for each vertex takes all adjacent polygons, sums their normal vectors
+ * weighted according to `weighting` and normalizes the sum.
+ * Polygons are gathered per vertex through a vertex-to-polygon adjacency,
+ * so vertices are processed concurrently without any synchronization and
+ * the result does not depend on the number of threads.
+ * Vertices that are not a part of any non-degenerate polygon get a zero normal
+ ******************************************************************************/
+std::vector<glm::vec3> calculate_vertex_normals(
+  std::vector<glm::vec3> const& vertices,
+  std::vector<glm::uvec3> const& indices,
+  NormalWeighting weighting,
+  size_t thread_count = playground::default_thread_count());
+
+#endif // PLAYGROUND_NORMALS_HPP
@@ -0,0 +1,117 @@
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include <fmt/format.h>
+#include <glm/gtc/packing.hpp>
+
+#include "packed_vertex.hpp"
+
+static float const unorm16_max = 65535.0F;
+
+/*******************************************************************************
+ * projects a unit vector onto the octahedron |x| + |y| + |z| = 1 and unfolds
+ * the lower half over the upper one, so the whole sphere fits into a square
+ ******************************************************************************/
+static glm::vec2 octahedral_encode(glm::vec3 n)
+{
+    auto const sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (sum == 0.0F) {
+        return {0.0F, 0.0F}; // vertices without a normal get +z
+    }
+    n /= sum;
+    if (n.z >= 0.0F) {
+        return {n.x, n.y};
+    }
+    return {
+      (1.0F - std::abs(n.y)) * (n.x >= 0.0F ? 1.0F : -1.0F),
+      (1.0F - std::abs(n.x)) * (n.y >= 0.0F ? 1.0F : -1.0F)};
+}
+
+static glm::vec3 octahedral_decode(glm::vec2 e)
+{
+    glm::vec3 n{e.x, e.y, 1.0F - std::abs(e.x) - std::abs(e.y)};
+    auto const t = std::max(-n.z, 0.0F);
+    n.x += n.x >= 0.0F ? -t : t;
+    n.y += n.y >= 0.0F ? -t : t;
+    return glm::normalize(n);
+}
+
+VertexQuantization quantize_bounds(glm::vec3 min_bound, glm::vec3 max_bound, float max_position_error)
+{
+    // rounding to the nearest step moves a position by at most half of the step
+    auto const extent = max_bound - min_bound;
+    auto const error = std::max({extent.x, extent.y, extent.z}) / unorm16_max * 0.5F;
+    if (error > max_position_error) {
+        throw std::runtime_error(fmt::format(
+          "positions spanning {} can not be quantized with an error below {}", error * 2.0F * unorm16_max, max_position_error));
+    }
+    return {min_bound, extent};
+}
+
+void pack_vertices(std::span<Vertex const> vertices, VertexQuantization const& quantization, std::span<PackedVertex> packed_vertices)
+{
+    if (packed_vertices.size() != vertices.size()) {
+        throw std::runtime_error(fmt::format("Expected room for {} packed vertices, got {}", vertices.size(), packed_vertices.size()));
+    }
+
+    auto const& extent = quantization.scale;
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        auto const& v = vertices[i];
+        PackedVertex packed{};
+        for (glm::length_t axis{}; axis < 3; ++axis) {
+            // a flat axis has no extent, every position on it is the offset itself
+            auto const normalized = extent[axis] > 0.0F ? (v.position[axis] - quantization.offset[axis]) / extent[axis] : 0.0F;
+            packed.position[static_cast<size_t>(axis)] = glm::packUnorm1x16(normalized);
+        }
+
+        auto const normal = octahedral_encode(v.normal);
+        packed.normal = {glm::packSnorm1x16(normal.x), glm::packSnorm1x16(normal.y)};
+        packed.uv = {glm::packHalf1x16(v.uv.x), glm::packHalf1x16(v.uv.y)};
+        packed_vertices[i] = packed;
+    }
+}
+
+VertexQuantization pack_vertices(std::span<Vertex const> vertices, float max_position_error, std::span<PackedVertex> packed_vertices)
+{
+    if (packed_vertices.size() != vertices.size()) {
+        throw std::runtime_error(fmt::format("Expected room for {} packed vertices, got {}", vertices.size(), packed_vertices.size()));
+    }
+    if (vertices.empty()) {
+        return {};
+    }
+
+    glm::vec3 min_bound{std::numeric_limits<float>::max()};
+    glm::vec3 max_bound{std::numeric_limits<float>::lowest()};
+    for (auto const& v : vertices) {
+        min_bound = glm::min(min_bound, v.position);
+        max_bound = glm::max(max_bound, v.position);
+    }
+
+    auto const res = quantize_bounds(min_bound, max_bound, max_position_error);
+    pack_vertices(vertices, res, packed_vertices);
+    return res;
+}
+
+PackedVertices pack_vertices(std::span<Vertex const> vertices, float max_position_error)
+{
+    PackedVertices res{};
+    res.vertices.resize(vertices.size());
+    res.quantization = pack_vertices(vertices, max_position_error, res.vertices);
+    return res;
+}
+
+Vertex unpack_vertex(PackedVertex const& vertex, VertexQuantization const& quantization)
+{
+    glm::vec3 const normalized{
+      glm::unpackUnorm1x16(vertex.position[0]),
+      glm::unpackUnorm1x16(vertex.position[1]),
+      glm::unpackUnorm1x16(vertex.position[2])};
+
+    glm::vec2 const normal{glm::unpackSnorm1x16(vertex.normal[0]), glm::unpackSnorm1x16(vertex.normal[1])};
+
+    return {
+      quantization.offset + normalized * quantization.scale,
+      octahedral_decode(normal),
+      {glm::unpackHalf1x16(vertex.uv[0]), glm::unpackHalf1x16(vertex.uv[1])}};
+}
@@ -0,0 +1,77 @@
+#ifndef PLAYGROUND_PACKED_VERTEX_HPP
+#define PLAYGROUND_PACKED_VERTEX_HPP
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "vertex.hpp"
+
+enum class VertexFormat {
+    Float, // `Vertex`, 32 bytes
+    Packed, // `PackedVertex`, 16 bytes
+};
+
+/*******************************************************************************
+ * half the size of `Vertex`:
+ * - position is unsigned normalized 16-bit within the bounds of its mesh,
+ * - normal is octahedral-encoded in two signed normalized 16-bit values,
+ * - uv is two half floats.
+ * All fields are raw bits as produced by the glm packing functions
+ ******************************************************************************/
+struct PackedVertex {
+    std::array<uint16_t, 3> position{};
+    uint16_t padding{};
+    std::array<uint16_t, 2> normal{};
+    std::array<uint16_t, 2> uv{};
+};
+
+static_assert(sizeof(PackedVertex) == 16);
+
+/*******************************************************************************
+ * maps normalized positions back to the model space:
+ * `position = offset + normalized_position * scale`.
+ * The default maps float positions onto themselves
+ ******************************************************************************/
+struct VertexQuantization {
+    glm::vec3 offset{0.0F};
+    glm::vec3 scale{1.0F};
+};
+
+struct PackedVertices {
+    std::vector<PackedVertex> vertices{};
+    VertexQuantization quantization{};
+};
+
+/*******************************************************************************
+ * quantizes vertices relative to their bounding box, throws if positions
+ * would move by more than `max_position_error` along any axis
+ ******************************************************************************/
+PackedVertices pack_vertices(std::span<Vertex const> vertices, float max_position_error);
+
+/*******************************************************************************
+ * the same into the caller's storage of exactly one packed vertex per vertex,
+ * e.g. mapped buffer memory, returns the quantization
+ ******************************************************************************/
+VertexQuantization pack_vertices(std::span<Vertex const> vertices, float max_position_error, std::span<PackedVertex> packed_vertices);
+
+/*******************************************************************************
+ * the quantization of positions within the bounds, throws as `pack_vertices` does
+ ******************************************************************************/
+VertexQuantization quantize_bounds(glm::vec3 min_bound, glm::vec3 max_bound, float max_position_error);
+
+/*******************************************************************************
+ * packs with a quantization of bounds known beforehand, so a mesh may be
+ * packed chunk by chunk, every position must lie within the bounds
+ ******************************************************************************/
+void pack_vertices(std::span<Vertex const> vertices, VertexQuantization const& quantization, std::span<PackedVertex> packed_vertices);
+
+/*******************************************************************************
+ * the inverse of `pack_vertices`, the shader does the same on the GPU
+ ******************************************************************************/
+Vertex unpack_vertex(PackedVertex const& vertex, VertexQuantization const& quantization);
+
+#endif // PLAYGROUND_PACKED_VERTEX_HPP
@@ -1,7 +1,16 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cmath>
+#include <cstring>
+#include <exception>
 #include <fstream>
+#include <limits>
 #include <numeric>
+#include <span>
+#include <utility>
 #include <sstream>
+#include <stdexcept>
 
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/ext/matrix_transform.hpp>
@@ -9,7 +18,9 @@
 #include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
 #include <imgui.h>
+#include <spdlog/spdlog.h>
 
+#include "packed_vertex.hpp"
 #include "vertex.hpp"
 
 #include "scene.hpp"
@@ -23,22 +34,36 @@ static std::string read_file(std::string const& path)
     return buffer.str();
 }
 
+// images of the texture atlases
+static size_t const white_image = 0;
+static size_t const crate_image = 1;
+
+// models larger than this are mapped from their cache rather than read into memory
+static char const* const model_path = "resources/bunny.obj";
+static size_t const model_memory_limit = 1024UL * 1024UL * 1024UL;
+
+// mapped models go to the buffers in chunks of at most this many bytes,
+// so only a window of them is ever paged in or packed at once
+static size_t const upload_chunk_size = 16UL * 1024UL * 1024UL;
+
 Scene::Scene() :
-  shapes_{&floor_, &sphere1_, &sphere2_, &cube_, &bunny_, &light_} {}
+  shapes_{&floor_, &sphere1_, &sphere2_, &cube_, &bunny_, &mapped_model_, &light_} {}
 
 void Scene::init()
 {
-    program_ = create_program(
-      read_file("GLSL/vertex.glsl"),
-      read_file("GLSL/fragment.glsl"));
-
-    light_program_ = create_program(
-      read_file("GLSL/light_vertex.glsl"),
-      read_file("GLSL/light_fragment.glsl"));
-
-    bunny_prototype_ = std::make_unique<StaticShape const>(load_model<StaticShape>("resources/bunny.obj"));
-    bunny_ = *bunny_prototype_;
+    program_ = load_program("GLSL/vertex.glsl", "GLSL/fragment.glsl");
+    light_program_ = load_program("GLSL/light_vertex.glsl", "GLSL/light_fragment.glsl");
+
+    // the model is drawn once it is loaded, until then it is an empty shape
+    LoadOptions model_options{};
+    model_options.memory_limit = model_memory_limit;
+    if (exceeds_memory_limit(model_path, model_options)) {
+        mapped_model_loading_ = map_shape_async(loader_pool_, model_path, model_options);
+    } else {
+        bunny_loading_ = load_model_async<StaticShape>(loader_pool_, resources_, model_path, model_options);
+    }
     bunny_.update();
+    mapped_model_.update();
 
     light_.set_size(0.1F);
     light_.update();
@@ -59,47 +84,202 @@ void Scene::init()
     sphere2_.set_position({2.0, 0.5, 0.0});
     sphere2_.update();
 
-    size_t const vertex_count = std::accumulate(shapes_.begin(), shapes_.end(), 0UL, [](auto sum, auto& s) {
-        return sum + s->vertex_count();
-    });
-
     /////// VBO ////////
     use_program(*program_);
-    size_t const vertex_data_size = vertex_count * sizeof(Vertex);
-    alloc_vbo(vertex_data_size);
-    size_t vbo_offset = 0;
-    for (auto& s : shapes_) {
-        auto const vbo_chunk_size = s->vertex_count();
-        upload_vbo(s->vbo_data(), vbo_offset * sizeof(Vertex), vbo_chunk_size * sizeof(Vertex));
-        s->set_vbo_offset(vbo_offset);
-        vbo_offset += vbo_chunk_size;
-    }
-    assign_vbo("position", decltype(Vertex::position)::length(), sizeof(Vertex), offsetof(Vertex, position));
-    assign_vbo("normal", decltype(Vertex::normal)::length(), sizeof(Vertex), offsetof(Vertex, normal));
-    assign_vbo("uv", decltype(Vertex::uv)::length(), sizeof(Vertex), offsetof(Vertex, uv));
+    upload_vertices();
 
     //////// IBO ////////
-    // We use universal index buffer where each polygon is represented by three sequential vertices in the vertex buffer
-    // so index buffer is just a sequence of integers for 0 to total count of vertices.
-    // We could use glDrawArrays, but for demonstration and future flexibility
-    // I decided to introduce the index buffer to the model
-    assert(vertex_count % 3 == 0);
-    size_t const index_count = vertex_count;
-    size_t const index_data_size = index_count * sizeof(uint32_t);
-    indices_.resize(index_count);
-    std::iota(indices_.begin(), indices_.end(), 0);
-    alloc_ibo(index_data_size);
-    upload_ibo(indices_.data(), 0, index_data_size);
-
-    png::RgbPixel const pixel_diffuse{255, 255, 255};
-    white_pixel_diffuse_.upload(&pixel_diffuse, 0, 0, 1, 1);
-    png::RedPixel const pixel_specular{255};
-    white_pixel_specular_.upload(&pixel_specular, 0, 0, 1, 1);
-
-    auto const cube_texture_image = png::read_png<png::RgbPixel>("textures/crate.png");
-    cube_diffuse_.upload(cube_texture_image.pixels, 0, 0, cube_texture_image.width, cube_texture_image.height);
-    auto const cube_specular_texture_image = png::read_png<png::RedPixel>("textures/crate_specular.png");
-    cube_specular_.upload(cube_specular_texture_image.pixels, 0, 0, cube_specular_texture_image.width, cube_specular_texture_image.height);
+    upload_indices();
+
+    // the crate's images share atlases with a white pixel used by the other objects,
+    // so the objects are drawn without rebinding textures. Both atlases are built
+    // or read from the texture cache concurrently, the objects are drawn once they are loaded
+    diffuse_atlas_.key = "textures/crate_diffuse.atlas";
+    diffuse_atlas_.loading = std::make_unique<playground::AtlasLoader>(loader_pool_,
+      std::vector<playground::MipLevel<png::RgbPixel>>{{{png::RgbPixel{255, 255, 255}}, 1, 1}},
+      std::vector<std::string>{"textures/crate.png"},
+      playground::AtlasOptions{512, 5, 1, playground::ColorSpace::Srgb, playground::MipFilter::Kaiser, playground::TextureCompression::Bc1},
+      diffuse_atlas_.key);
+    specular_atlas_.key = "textures/crate_specular.atlas";
+    specular_atlas_.loading = std::make_unique<playground::AtlasLoader>(loader_pool_,
+      std::vector<playground::MipLevel<png::RedPixel>>{{{png::RedPixel{255}}, 1, 1}},
+      std::vector<std::string>{"textures/crate_specular.png"},
+      playground::AtlasOptions{512, 5, 1, playground::ColorSpace::Linear, playground::MipFilter::Box, playground::TextureCompression::Bc4},
+      specular_atlas_.key);
+
+    resolve_uniforms();
+}
+
+/*******************************************************************************
+ * looks the uniforms set every frame up once, a name missing from a program
+ * or of another type fails here rather than in the middle of a frame
+ ******************************************************************************/
+void Scene::resolve_uniforms()
+{
+    auto const& p = *program_;
+    object_uniforms_ = {
+      p.uniform<glm::mat4>("view"),
+      p.uniform<glm::mat4>("proj"),
+      p.uniform<glm::mat4>("model"),
+      p.uniform<glm::vec3>("light_position"),
+      p.uniform<glm::vec3>("camera_position"),
+      p.uniform<bool>("octahedral_normals"),
+      p.uniform<GLint>("diffuse_texture"),
+      p.uniform<GLint>("specular_texture"),
+      p.uniform<GLint>("first_draw")};
+
+    auto const& l = *light_program_;
+    light_uniforms_ = {
+      l.uniform<glm::mat4>("view"),
+      l.uniform<glm::mat4>("proj"),
+      l.uniform<glm::mat4>("model"),
+      {l.uniform<glm::vec3>("position_offset"), l.uniform<glm::vec3>("position_scale")}};
+}
+
+/*******************************************************************************
+ * once the atlas is built, its pages become layers of the pool's arrays, their
+ * small levels are streamed within the upload budget of the next frames and
+ * the finer ones once the objects using them need them. The layers are shared
+ * through the resource manager, which accounts for the decoded levels the
+ * residency keeps of them. Their GPU levels are accounted by the residency's
+ * own budget, which decides how many of them are on the GPU at a time
+ ******************************************************************************/
+void Scene::load_atlas(AtlasTextures& textures, playground::TextureArrayPool& arrays)
+{
+    if (!textures.loading) {
+        return;
+    }
+
+    try {
+        auto loaded = textures.loading->poll();
+        if (!loaded) {
+            return;
+        }
+        textures.loading.reset();
+
+        auto& atlas = *loaded;
+        textures.pages = resources_.get<AtlasPages const>(textures.key, [&]() {
+            // the residency keeps every level in main memory to stream evicted ones back
+            playground::ResourceSize size{};
+            auto pages = std::make_shared<AtlasPages>(arrays, texture_residency_);
+            for (auto& page : atlas.pages) {
+                for (size_t level = 0; level < playground::image_format(page).levels; ++level) {
+                    size.cpu_bytes += playground::image_level(page, level).size();
+                }
+                pages->layers.push_back(texture_residency_.add(arrays, std::move(page)));
+            }
+            pages->regions = std::move(atlas.regions);
+            return playground::LoadedResource<AtlasPages const>{pages, size};
+        });
+    } catch (std::exception const& e) {
+        spdlog::error("could not load a texture atlas: {}", e.what());
+        textures.loading.reset();
+    }
+}
+
+Scene::AtlasPages::~AtlasPages()
+{
+    for (auto const& layer : layers) {
+        residency.remove(layer);
+        arrays.release(layer);
+    }
+}
+
+// the arrays holding the pages of the image in both atlases
+std::pair<GLuint, GLuint> Scene::atlas_arrays(size_t image) const
+{
+    auto const page_array = [image](AtlasTextures const& atlas) {
+        auto const& region = atlas.pages->regions.at(image);
+        return atlas.pages->layers.at(region.page).array->id();
+    };
+    return {page_array(diffuse_atlas_), page_array(specular_atlas_)};
+}
+
+/*******************************************************************************
+ * binds the arrays holding the pages of the image to both samplers, an array
+ * is bound only when it is not the one bound by the previous draws
+ ******************************************************************************/
+void Scene::bind_atlas_arrays(size_t image)
+{
+    auto const bind = [this, image](AtlasTextures& atlas) {
+        auto const& region = atlas.pages->regions.at(image);
+        auto const& page = atlas.pages->layers.at(region.page);
+        if (atlas.bound_array != page.array->id()) {
+            page.array->bind();
+            atlas.bound_array = page.array->id();
+            ++texture_binds_;
+        }
+    };
+    bind(diffuse_atlas_);
+    bind(specular_atlas_);
+}
+
+/*******************************************************************************
+ * everything the shaders need to draw the shape with the image and the material,
+ * images on other pages of the same array only change the layer
+ ******************************************************************************/
+Scene::ObjectRecord Scene::object_record(Shape const& shape, size_t image, materials::Material const& material) const
+{
+    auto const& diffuse = diffuse_atlas_.pages->regions.at(image);
+    auto const& specular = specular_atlas_.pages->regions.at(image);
+
+    ObjectRecord res{};
+    res.position_offset = glm::vec4{shape.quantization().offset, 0.0F};
+    res.position_scale = glm::vec4{shape.quantization().scale, 0.0F};
+    res.diffuse_uv_rect = diffuse.uv_rect;
+    res.specular_uv_rect = specular.uv_rect;
+    res.ambient = glm::vec4{material.ambient, 0.0F};
+    res.diffuse = glm::vec4{material.diffuse, 0.0F};
+    res.specular_shininess = glm::vec4{material.specular, material.shininess};
+    res.layers = {
+      static_cast<GLint>(diffuse_atlas_.pages->layers.at(diffuse.page).layer),
+      static_cast<GLint>(specular_atlas_.pages->layers.at(specular.page).layer),
+      0,
+      0};
+    return res;
+}
+
+/*******************************************************************************
+ * requests the pages of the image at the level which matches the size of the
+ * shape on the screen, the shape is approximated by the bounds of its meshlets
+ ******************************************************************************/
+void Scene::request_texture_levels(Shape const& shape, size_t image, glm::mat4 const& view, glm::mat4 const& proj)
+{
+    auto const& meshlets = shape.meshlets(0);
+    if (meshlets.empty()) {
+        return;
+    }
+
+    glm::vec3 min_bound{std::numeric_limits<float>::max()};
+    glm::vec3 max_bound{std::numeric_limits<float>::lowest()};
+    for (auto const& meshlet : meshlets) {
+        min_bound = glm::min(min_bound, meshlet.center - meshlet.radius);
+        max_bound = glm::max(max_bound, meshlet.center + meshlet.radius);
+    }
+    auto const center = view * glm::vec4{(min_bound + max_bound) * 0.5F, 1.0F};
+    auto const radius = glm::length(max_bound - min_bound) * 0.5F;
+    auto const distance = std::max(-center.z - radius, 1e-3F);
+
+    // the projected diameter as in `select_lod`
+    auto const pixels = radius * proj[1][1] * static_cast<float>(window_size().y) / distance;
+
+    for (auto* atlas : {&diffuse_atlas_, &specular_atlas_}) {
+        auto const& region = atlas->pages->regions.at(image);
+        auto const& page = atlas->pages->layers.at(region.page);
+
+        // every level halves the texels of the image across the shape
+        auto const texels = std::max(region.uv_rect.z, region.uv_rect.w) * static_cast<float>(page.array->format().width);
+        auto const level = std::max(std::log2(texels / std::max(pixels, 1.0F)), 0.0F);
+        texture_residency_.request(page, static_cast<size_t>(level), pixels);
+    }
+}
+
+std::shared_ptr<playground::Program> Scene::load_program(std::string const& vertex_path, std::string const& fragment_path)
+{
+    return resources_.get<playground::Program>(fmt::format("{}:{}", vertex_path, fragment_path), [&]() {
+        std::shared_ptr<playground::Program> program = create_program(read_file(vertex_path), read_file(fragment_path));
+        return playground::LoadedResource<playground::Program>{program, {}};
+    });
 }
 
 void Scene::present_imgui()
@@ -116,6 +296,85 @@ void Scene::present_imgui()
     ImGui::SliderFloat("Zoom", &camera_zoom_, glm::half_pi<float>(), glm::quarter_pi<float>());
     ImGui::SliderFloat("Lens shift", &lens_shift_, -1.0F, 1.0F);
 
+    int vertex_format = static_cast<int>(vertex_format_);
+    ImGui::Text("Vertex format:");
+    ImGui::SameLine();
+    bool format_changed = ImGui::RadioButton("Float", &vertex_format, static_cast<int>(VertexFormat::Float));
+    ImGui::SameLine();
+    format_changed |= ImGui::RadioButton("Packed", &vertex_format, static_cast<int>(VertexFormat::Packed));
+    if (format_changed) {
+        vertex_format_ = static_cast<VertexFormat>(vertex_format);
+        use_program(*program_);
+        upload_vertices();
+    }
+
+    int texture_filter = static_cast<int>(texture_filter_);
+    ImGui::Text("Texture filter:");
+    ImGui::SameLine();
+    bool filter_changed = ImGui::RadioButton("Nearest", &texture_filter, static_cast<int>(playground::TextureFilter::Nearest));
+    ImGui::SameLine();
+    filter_changed |= ImGui::RadioButton("Linear", &texture_filter, static_cast<int>(playground::TextureFilter::Linear));
+    ImGui::SameLine();
+    filter_changed |= ImGui::RadioButton("Trilinear", &texture_filter, static_cast<int>(playground::TextureFilter::Trilinear));
+    if (filter_changed) {
+        texture_filter_ = static_cast<playground::TextureFilter>(texture_filter);
+        diffuse_arrays_.set_filter(texture_filter_);
+        specular_arrays_.set_filter(texture_filter_);
+    }
+
+    ImGui::Text("Texture binds: %zu, object draw calls: %zu per frame", texture_binds_, object_draw_calls_);
+
+    ImGui::SliderFloat("LOD error (px)", &lod_pixel_error_, 0.1F, 10.0F);
+    ImGui::Text("Bunny LOD: %zu of %zu, %zu triangles",
+      bunny_lod_, bunny_.lod_count(), bunny_.lod(bunny_lod_).index_count / 3);
+
+    ImGui::Checkbox("Meshlet culling", &meshlet_culling_);
+    if (meshlet_culling_) {
+        ImGui::Text("Meshlets: %zu of %zu visible", culling_stats_.visible_meshlets, culling_stats_.meshlets);
+        ImGui::Text("Triangles: %zu of %zu rejected",
+          culling_stats_.triangles - culling_stats_.visible_triangles, culling_stats_.triangles);
+        ImGui::Text("Culling time: %.3f ms", culling_stats_.time_ms);
+    }
+
+    auto const resource_stats = resources_.stats();
+    auto const to_megabytes = [](size_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+    ImGui::Text("Resources: %zu cached, %zu in use", resource_stats.entries, resource_stats.referenced_entries);
+    ImGui::Text("Resource hits %zu, misses %zu, evictions %zu",
+      resource_stats.hits, resource_stats.misses, resource_stats.evictions);
+    ImGui::Text("Resource memory: CPU %.1f MB, GPU %.1f MB",
+      to_megabytes(resource_stats.size.cpu_bytes), to_megabytes(resource_stats.size.gpu_bytes));
+
+    auto const& streaming = texture_streamer_.stats();
+    ImGui::Text("Texture streaming: %.2f MB queued, %.2f MB last frame, %.2f MB total",
+      to_megabytes(streaming.queued_bytes), to_megabytes(streaming.frame_bytes), to_megabytes(streaming.uploaded_bytes));
+    ImGui::Text("Frames waiting for the GPU: %zu", streaming.waiting_frames);
+
+    auto const& residency = texture_residency_.stats();
+    ImGui::Text("Texture residency: %.2f of %.2f MB, %.2f MB requested",
+      to_megabytes(residency.resident_bytes), to_megabytes(residency.budget), to_megabytes(residency.requested_bytes));
+    ImGui::Text("Levels loading %zu, evicted %zu (%.2f MB), %zu evicted in total",
+      residency.loaded_levels, residency.evicted_levels, to_megabytes(residency.evicted_bytes), residency.total_evictions);
+    ImGui::Text("Arrays streaming %zu, over budget %zu", residency.loading_arrays, residency.over_budget_arrays);
+
+    auto texture_budget = static_cast<float>(to_megabytes(residency.budget));
+    if (ImGui::SliderFloat("Texture budget (MB)", &texture_budget, 0.0F, 16.0F, "%.2f")) {
+        texture_residency_.set_budget(static_cast<size_t>(texture_budget * 1024.0F * 1024.0F));
+    }
+
+    for (auto const* arrays : {&diffuse_arrays_, &specular_arrays_}) {
+        auto const array_stats = arrays->stats();
+        ImGui::Text("Texture arrays: %zu, layers %zu of %zu used, GPU %.1f MB",
+          array_stats.arrays, array_stats.used_layers, array_stats.layers, to_megabytes(array_stats.gpu_bytes));
+    }
+
+    int cpu_budget = static_cast<int>(resource_stats.budget.cpu_bytes / (1024 * 1024));
+    int gpu_budget = static_cast<int>(resource_stats.budget.gpu_bytes / (1024 * 1024));
+    bool budget_changed = ImGui::SliderInt("CPU budget (MB)", &cpu_budget, 0, 4096);
+    budget_changed |= ImGui::SliderInt("GPU budget (MB)", &gpu_budget, 0, 4096);
+    if (budget_changed) {
+        resources_.set_budget({static_cast<size_t>(cpu_budget) * 1024 * 1024, static_cast<size_t>(gpu_budget) * 1024 * 1024});
+    }
+
     ImGui::SliderFloat3("Light Position", glm::value_ptr(light_position_), -5, 5);
 
     if (ImGui::SliderFloat("Scale", &scale_, 0.0F, 2.0F)) {
@@ -128,16 +387,84 @@ void Scene::present_imgui()
         bunny_.set_scale(scale_);
         bunny_.update();
 
-        upload_vbo(sphere1_.vbo_data(), sphere1_.vbo_offset() * sizeof(Vertex), sphere1_.vertex_count() * sizeof(Vertex));
-        upload_vbo(sphere2_.vbo_data(), sphere2_.vbo_offset() * sizeof(Vertex), sphere2_.vertex_count() * sizeof(Vertex));
-        upload_vbo(bunny_.vbo_data(), bunny_.vbo_offset() * sizeof(Vertex), bunny_.vertex_count() * sizeof(Vertex));
+        // streamed while the slider moves, `update` writes them
+        for (Shape* shape : {static_cast<Shape*>(&sphere1_), static_cast<Shape*>(&sphere2_), static_cast<Shape*>(&bunny_)}) {
+            if (std::find_if(dynamic_shapes_.begin(), dynamic_shapes_.end(), [shape](auto const& dynamic) { return dynamic.first == shape; })
+              == dynamic_shapes_.end()) {
+                dynamic_shapes_.emplace_back(shape, 0);
+            }
+        }
+        dynamic_shapes_changed_ = true;
+    }
+    auto const stream_vbo = stream_vbo_stats();
+    ImGui::Text("Stream VBO: %.2f of %.2f MB last frame, %zu stalled frames",
+      to_megabytes(stream_vbo.frame_bytes), to_megabytes(stream_vbo.frame_size), stream_vbo.stalled_frames);
+
+    int capture_format = static_cast<int>(capture_format_);
+    ImGui::Text("Capture format:");
+    ImGui::SameLine();
+    ImGui::RadioButton("PNG", &capture_format, static_cast<int>(playground::CaptureFormat::Png));
+    ImGui::SameLine();
+    ImGui::RadioButton("Y4M", &capture_format, static_cast<int>(playground::CaptureFormat::Y4m));
+    capture_format_ = static_cast<playground::CaptureFormat>(capture_format);
+
+    bool capturing = this->capturing();
+    if (ImGui::Checkbox("Capture frames", &capturing)) {
+        if (capturing) {
+            start_capture({.format = capture_format_});
+        } else {
+            stop_capture();
+        }
     }
+    auto const capture = capture_stats();
+    ImGui::Text("Frames captured %zu, written %zu, dropped %zu, pending %zu, failed %zu",
+      capture.captured_frames, capture.written_frames, capture.dropped_frames, capture.pending_frames, capture.failed_frames);
 
     ImGui::End();
 }
 
 void Scene::update()
 {
+    using namespace std::chrono_literals;
+
+    resources_.collect();
+    load_atlas(diffuse_atlas_, diffuse_arrays_);
+    load_atlas(specular_atlas_, specular_arrays_);
+    texture_residency_.update();
+    texture_streamer_.update();
+    write_dynamic_vertices();
+
+    if (bunny_loading_.valid() && bunny_loading_.wait_for(0s) == std::future_status::ready) {
+        try {
+            bunny_prototype_ = std::make_unique<StaticShape const>(bunny_loading_.get());
+        } catch (std::exception const& e) {
+            spdlog::error("could not load the bunny: {}", e.what());
+            return;
+        }
+
+        bunny_ = *bunny_prototype_;
+        bunny_.set_scale(scale_);
+        bunny_.update();
+
+        // the bunny changes the sizes of both buffers, so they are rebuilt as a whole
+        use_program(*program_);
+        upload_vertices();
+        upload_indices();
+    }
+
+    if (mapped_model_loading_.valid() && mapped_model_loading_.wait_for(0s) == std::future_status::ready) {
+        try {
+            mapped_model_ = mapped_model_loading_.get();
+        } catch (std::exception const& e) {
+            spdlog::error("could not map the model: {}", e.what());
+            return;
+        }
+        mapped_model_.update();
+
+        use_program(*program_);
+        upload_vertices();
+        upload_indices();
+    }
 }
 
 void Scene::render()
@@ -148,39 +475,141 @@ void Scene::render()
     // find the camera position from the view matrix
     auto camera_position = glm::inverse(view) * glm::vec4{0.0F, 0.0F, 0.0F, 1.0F};
 
-    // Objects
-    use_program(*program_);
-    set_uniform_data("view", view);
-    set_uniform_data("proj", proj);
-    set_uniform_data("model", glm::mat4(1.0F));
-    set_uniform_data("light_position", light_position_);
-    set_uniform_data("camera_position", glm::vec3(camera_position));
+    culling_stats_ = {};
+
+    // the objects are drawn once their textures are loaded, as the bunny is
+    if (diffuse_atlas_.pages && specular_atlas_.pages) {
+        render_objects(view, proj, glm::vec3(camera_position));
+    }
 
-    set_uniform_data("diffuse_texture", 0);
-    set_uniform_data("specular_texture", 1);
+    // Light
+    use_program(*light_program_);
+    light_uniforms_.view.set(view);
+    light_uniforms_.proj.set(proj);
+    auto const light_model = glm::translate(glm::mat4(1.0F), light_position_);
+    light_uniforms_.model.set(light_model);
+    set_culling_transform(view, proj, light_model);
+    draw_shape(light_uniforms_.shape, light_);
+}
 
-    white_pixel_diffuse_.bind();
-    white_pixel_specular_.bind();
+/*******************************************************************************
+ * draws the objects with as few calls as their vertex buffers and texture
+ * arrays allow. The data of every object goes into a storage buffer and every
+ * visible range of the IBO is a draw of a multi draw call, the shaders find
+ * the object of the draw at `gl_DrawID`. So all static objects sharing the
+ * texture arrays are one call, dynamic ones, read from the stream VBO at their
+ * own base vertices, take a call each
+ ******************************************************************************/
+void Scene::render_objects(glm::mat4 const& view, glm::mat4 const& proj, glm::vec3 const& camera_position)
+{
+    set_culling_transform(view, proj, glm::mat4(1.0F));
 
-    set_material(materials::WhiteRubber);
-    draw_indices(cube_.vbo_offset(), Triangles);
+    use_program(*program_);
+    auto const& uniforms = object_uniforms_;
+    uniforms.view.set(view);
+    uniforms.proj.set(proj);
+    uniforms.model.set(glm::mat4(1.0F));
+    uniforms.light_position.set(light_position_);
+    uniforms.camera_position.set(camera_position);
+
+    uniforms.octahedral_normals.set(vertex_format_ == VertexFormat::Packed);
+    uniforms.diffuse_texture.set(0);
+    uniforms.specular_texture.set(1);
+
+    struct Object {
+        Shape const* shape{};
+        size_t image{};
+        materials::Material material;
+        size_t level{};
+    };
+
+    bunny_lod_ = select_lod(bunny_, bunny_.bounds_center(), bunny_.bounds_radius(), view, proj);
+    auto const mapped_model_lod = select_lod(mapped_model_, mapped_model_.bounds_center(), mapped_model_.bounds_radius(), view, proj);
+    std::array<Object, 6> const objects{{
+      {&floor_, white_image, materials::WhiteRubber, 0},
+      {&sphere1_, white_image, materials::WhiteRubber, 0},
+      {&sphere2_, white_image, materials::WhiteRubber, 0},
+      {&cube_, crate_image, materials::Wood, 0},
+      {&bunny_, white_image, materials::Gold, bunny_lod_},
+      {&mapped_model_, white_image, materials::Gold, mapped_model_lod}}};
+
+    // textures are kept as fine as the objects using them appear on the screen
+    object_records_.clear();
+    for (auto const& object : objects) {
+        request_texture_levels(*object.shape, object.image, view, proj);
+        object_records_.push_back(object_record(*object.shape, object.image, object.material));
+    }
 
-    set_material(materials::Wood);
-    cube_diffuse_.bind();
-    cube_specular_.bind();
-    draw_indices(cube_.vertex_count(), Triangles, cube_.vbo_offset());
-    white_pixel_diffuse_.bind();
-    white_pixel_specular_.bind();
+    // static objects go first, their batch breaks only where the texture arrays change
+    visible_ranges_.clear();
+    draw_base_vertices_.clear();
+    draw_objects_.clear();
+    draw_batches_.clear();
+    for (bool const dynamic : {false, true}) {
+        for (size_t i = 0; i < objects.size(); ++i) {
+            auto const& object = objects[i];
+            auto const base_vertex = stream_base_vertex(*object.shape);
+            if (base_vertex.has_value() != dynamic) {
+                continue;
+            }
+
+            auto const arrays = atlas_arrays(object.image);
+            if (dynamic || draw_batches_.empty() || draw_batches_.back().arrays != arrays) {
+                draw_batches_.push_back({arrays, object.image, dynamic, visible_ranges_.size(), 0});
+            }
+            cull_shape(*object.shape, object.level, base_vertex.value_or(object.shape->vbo_offset()));
+            draw_objects_.resize(visible_ranges_.size(), static_cast<uint32_t>(i));
+            draw_batches_.back().draw_count = visible_ranges_.size() - draw_batches_.back().first_draw;
+        }
+    }
 
-    set_material(materials::Gold);
-    draw_indices(bunny_.vertex_count(), Triangles, bunny_.vbo_offset());
+    object_draw_calls_ = 0;
+    if (visible_ranges_.empty()) {
+        return;
+    }
+    write_draw_storage();
+
+    // other code may bind textures between frames
+    diffuse_atlas_.bound_array = 0;
+    specular_atlas_.bound_array = 0;
+    texture_binds_ = 0;
+
+    std::span<IndexRange const> const ranges{visible_ranges_};
+    std::span<size_t const> const base_vertices{draw_base_vertices_};
+    for (auto const& batch : draw_batches_) {
+        if (batch.draw_count == 0) {
+            continue;
+        }
+        bind_atlas_arrays(batch.image);
+        if (batch.dynamic) {
+            use_stream_vbo();
+        } else {
+            use_vbo();
+        }
+        uniforms.first_draw.set(static_cast<GLint>(batch.first_draw));
+        draw_multi_indices(ranges.subspan(batch.first_draw, batch.draw_count),
+          base_vertices.subspan(batch.first_draw, batch.draw_count));
+        ++object_draw_calls_;
+    }
+}
 
-    // Light
-    use_program(*light_program_);
-    set_uniform_data("view", view);
-    set_uniform_data("proj", proj);
-    set_uniform_data("model", glm::translate(glm::mat4(1.0F), light_position_));
-    draw_indices(light_.vertex_count(), Triangles, light_.vbo_offset());
+/*******************************************************************************
+ * writes the records of the objects and the object of every draw into the
+ * storage buffer of this frame, it grows when a frame needs more
+ ******************************************************************************/
+void Scene::write_draw_storage()
+{
+    auto const records_size = object_records_.size() * sizeof(ObjectRecord);
+    auto const draws_size = draw_objects_.size() * sizeof(uint32_t);
+    auto const frame_size = records_size + draws_size + 2 * stream_storage_alignment();
+    if (stream_storage_stats().frame_size < frame_size) {
+        alloc_stream_storage(std::max(frame_size, stream_storage_stats().frame_size * 2));
+    }
+
+    auto const records = map_stream_storage(0, records_size);
+    std::memcpy(records.data.data(), object_records_.data(), records_size);
+    auto const draws = map_stream_storage(1, draws_size);
+    std::memcpy(draws.data.data(), draw_objects_.data(), draws_size);
 }
 
 void Scene::drag_mouse(glm::ivec2 offset, KeyModifiers modifiers)
@@ -237,10 +666,278 @@ glm::mat4 Scene::proj_matrix()
     return proj;
 }
 
-void Scene::set_material(materials::Material const& material)
+/*******************************************************************************
+ * picks the coarsest level of detail whose error, projected onto the screen
+ * at the nearest point of the shape's bounding sphere, stays within
+ * `lod_pixel_error_` pixels
+ ******************************************************************************/
+size_t Scene::select_lod(Shape const& shape, glm::vec3 center, float radius, glm::mat4 const& view, glm::mat4 const& proj)
+{
+    auto const view_center = view * glm::vec4{center, 1.0F};
+    auto const distance = std::max(-view_center.z - radius, 1e-3F);
+
+    // proj[1][1] is the cotangent of the half of the vertical field of view,
+    // it maps a view space size at the distance of 1 onto half of the viewport height
+    auto const pixels_per_unit = proj[1][1] * 0.5F * static_cast<float>(window_size().y) / distance;
+
+    size_t res = 0;
+    for (size_t level = 1; level < shape.lod_count(); ++level) {
+        if (shape.lod(level).error * pixels_per_unit > lod_pixel_error_) {
+            break;
+        }
+        res = level;
+    }
+    return res;
+}
+
+/*******************************************************************************
+ * allocates the VBO for all shapes in the current vertex format,
+ * uploads them and points the attributes of the current program at them
+ ******************************************************************************/
+void Scene::upload_vertices()
 {
-    set_uniform_data("material.ambient", material.ambient);
-    set_uniform_data("material.diffuse", material.diffuse);
-    set_uniform_data("material.specular", material.specular);
-    set_uniform_data("material.shininess", material.shininess);
+    auto const vertex_size = vertex_format_ == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+    size_t const vertex_count = std::accumulate(shapes_.begin(), shapes_.end(), 0UL, [](auto sum, auto& s) {
+        return sum + s->vertex_count();
+    });
+
+    alloc_vbo(vertex_count * vertex_size);
+    // room for every shape in the larger format, so switching the format keeps the size
+    alloc_stream_vbo(vertex_count * sizeof(Vertex));
+    dynamic_shapes_.clear();
+
+    size_t vbo_offset = 0;
+    try {
+        for (auto& s : shapes_) {
+            s->set_vbo_offset(vbo_offset);
+            upload_shape_vertices(*s);
+            vbo_offset += s->vertex_count();
+        }
+    } catch (std::runtime_error const& e) {
+        if (vertex_format_ != VertexFormat::Packed) {
+            throw;
+        }
+        use_float_vertices(e);
+        return;
+    }
+
+    switch (vertex_format_) {
+    case VertexFormat::Float:
+        assign_vbo("position", decltype(Vertex::position)::length(), sizeof(Vertex), offsetof(Vertex, position));
+        assign_vbo("normal", decltype(Vertex::normal)::length(), sizeof(Vertex), offsetof(Vertex, normal));
+        assign_vbo("uv", decltype(Vertex::uv)::length(), sizeof(Vertex), offsetof(Vertex, uv));
+        break;
+    case VertexFormat::Packed:
+        assign_vbo("position", 3, AttributeType::UnsignedShort, true, sizeof(PackedVertex), offsetof(PackedVertex, position));
+        assign_vbo("normal", 2, AttributeType::Short, true, sizeof(PackedVertex), offsetof(PackedVertex, normal));
+        assign_vbo("uv", 2, AttributeType::HalfFloat, false, sizeof(PackedVertex), offsetof(PackedVertex, uv));
+        break;
+    }
+}
+
+/*******************************************************************************
+ * Every shape provides its own indices, local to the shape's vertices.
+ * All of them share one index buffer, and the shape's offset in the VBO
+ * is passed as the base vertex when drawing, so indices need no rebasing
+ ******************************************************************************/
+void Scene::upload_indices()
+{
+    size_t const index_count = std::accumulate(shapes_.begin(), shapes_.end(), 0UL, [](auto sum, auto& s) {
+        return sum + s->index_count();
+    });
+    alloc_ibo(index_count * sizeof(uint32_t));
+    size_t ibo_offset = 0;
+    for (auto& s : shapes_) {
+        std::span<uint32_t const> const indices{s->ibo_data(), s->index_count()};
+        for (size_t first = 0; first < indices.size(); first += upload_chunk_size / sizeof(uint32_t)) {
+            auto const chunk = indices.subspan(first, std::min(upload_chunk_size / sizeof(uint32_t), indices.size() - first));
+            upload_ibo(chunk.data(), (ibo_offset + first) * sizeof(uint32_t), chunk.size_bytes());
+        }
+        s->set_ibo_offset(ibo_offset);
+        ibo_offset += indices.size();
+    }
+}
+
+/*******************************************************************************
+ * uploads vertices of the shape at its offset in the VBO chunk by chunk,
+ * packed shapes are quantized within their own bounds
+ ******************************************************************************/
+void Scene::upload_shape_vertices(Shape& shape)
+{
+    std::span<Vertex const> const vertices{shape.vbo_data(), shape.vertex_count()};
+    size_t const chunk_vertices = upload_chunk_size / sizeof(Vertex);
+
+    switch (vertex_format_) {
+    case VertexFormat::Float:
+        shape.set_quantization({});
+        for (size_t first = 0; first < vertices.size(); first += chunk_vertices) {
+            auto const chunk = vertices.subspan(first, std::min(chunk_vertices, vertices.size() - first));
+            upload_vbo(chunk.data(), (shape.vbo_offset() + first) * sizeof(Vertex), chunk.size_bytes());
+        }
+        break;
+    case VertexFormat::Packed: {
+        if (vertices.empty()) {
+            shape.set_quantization({});
+            break;
+        }
+        // every chunk is packed within the bounds of the whole shape
+        auto const [min_bound, max_bound] = shape.vertex_bounds();
+        auto const quantization = quantize_bounds(min_bound, max_bound, max_position_error_);
+        std::vector<PackedVertex> packed(std::min(chunk_vertices, vertices.size()));
+        for (size_t first = 0; first < vertices.size(); first += chunk_vertices) {
+            auto const chunk = vertices.subspan(first, std::min(chunk_vertices, vertices.size() - first));
+            std::span<PackedVertex> const packed_chunk{packed.data(), chunk.size()};
+            pack_vertices(chunk, quantization, packed_chunk);
+            upload_vbo(packed_chunk.data(), (shape.vbo_offset() + first) * sizeof(PackedVertex), packed_chunk.size_bytes());
+        }
+        shape.set_quantization(quantization);
+        break;
+    }
+    }
+}
+
+/*******************************************************************************
+ * writes the vertices of the shapes changed in this frame straight into the
+ * mapped stream VBO, packed ones are packed into it. Once they stop changing,
+ * they go back to the VBO with a single upload each
+ ******************************************************************************/
+void Scene::write_dynamic_vertices()
+{
+    if (!dynamic_shapes_changed_) {
+        try {
+            for (auto const& [shape, base_vertex] : dynamic_shapes_) {
+                upload_shape_vertices(*shape);
+            }
+        } catch (std::runtime_error const& e) {
+            if (vertex_format_ != VertexFormat::Packed) {
+                throw;
+            }
+            use_float_vertices(e);
+        }
+        dynamic_shapes_.clear();
+        return;
+    }
+    dynamic_shapes_changed_ = false;
+
+    for (auto& [shape, base_vertex] : dynamic_shapes_) {
+        std::span<Vertex const> const vertices{shape->vbo_data(), shape->vertex_count()};
+        switch (vertex_format_) {
+        case VertexFormat::Float: {
+            auto const allocation = map_stream_vbo(vertices.size_bytes(), sizeof(Vertex));
+            std::memcpy(allocation.data.data(), vertices.data(), vertices.size_bytes());
+            shape->set_quantization({});
+            base_vertex = allocation.offset / sizeof(Vertex);
+            break;
+        }
+        case VertexFormat::Packed: {
+            auto const allocation = map_stream_vbo(vertices.size() * sizeof(PackedVertex), sizeof(PackedVertex));
+            // the allocation is aligned to the vertex size, so it holds whole vertices
+            std::span<PackedVertex> const packed{reinterpret_cast<PackedVertex*>(allocation.data.data()), vertices.size()};
+            try {
+                shape->set_quantization(pack_vertices(vertices, max_position_error_, packed));
+            } catch (std::runtime_error const& e) {
+                // the shapes of this frame go into the VBO as floats instead
+                use_float_vertices(e);
+                return;
+            }
+            base_vertex = allocation.offset / sizeof(PackedVertex);
+            break;
+        }
+        }
+    }
+}
+
+/*******************************************************************************
+ * packed positions cannot span more than 65535 steps of `max_position_error_`,
+ * a shape larger than that, e.g. a big scan, switches the scene to float
+ * vertices instead of failing
+ ******************************************************************************/
+void Scene::use_float_vertices(std::exception const& packing_error)
+{
+    spdlog::warn("falling back to float vertices: {}", packing_error.what());
+    vertex_format_ = VertexFormat::Float;
+    use_program(*program_);
+    upload_vertices();
+}
+
+/*******************************************************************************
+ * meshlets are culled in the space of the shape's vertices,
+ * so the frustum and the camera are moved into that space
+ ******************************************************************************/
+void Scene::set_culling_transform(glm::mat4 const& view, glm::mat4 const& proj, glm::mat4 const& model)
+{
+    culling_frustum_ = extract_frustum(proj * view * model);
+    culling_camera_position_ = glm::vec3(glm::inverse(view * model) * glm::vec4{0.0F, 0.0F, 0.0F, 1.0F});
+}
+
+std::optional<size_t> Scene::stream_base_vertex(Shape const& shape) const
+{
+    auto const dynamic = std::find_if(dynamic_shapes_.begin(), dynamic_shapes_.end(), [&shape](auto const& dynamic) {
+        return dynamic.first == &shape;
+    });
+    if (dynamic == dynamic_shapes_.end()) {
+        return std::nullopt;
+    }
+    return dynamic->second;
+}
+
+/*******************************************************************************
+ * appends the visible ranges of the shape to the draws, all with the base vertex
+ ******************************************************************************/
+void Scene::cull_shape(Shape const& shape, size_t level, size_t base_vertex)
+{
+    // shapes without meshlets, e.g. mapped ones, are drawn whole
+    if (!meshlet_culling_ || shape.meshlets(level).empty()) {
+        auto const lod = shape.lod(level);
+        if (lod.index_count != 0) {
+            visible_ranges_.push_back({shape.ibo_offset() + lod.index_offset, lod.index_count});
+            draw_base_vertices_.push_back(base_vertex);
+        }
+        return;
+    }
+
+    auto const culling_start = std::chrono::steady_clock::now();
+
+    // consecutive visible meshlets are adjacent in the IBO and merge into one range
+    auto const first_range = visible_ranges_.size();
+    for (auto const& meshlet : shape.meshlets(level)) {
+        culling_stats_.meshlets += 1;
+        culling_stats_.triangles += meshlet.index_count / 3;
+        if (!is_meshlet_visible(meshlet, culling_frustum_, culling_camera_position_)) {
+            continue;
+        }
+        culling_stats_.visible_meshlets += 1;
+        culling_stats_.visible_triangles += meshlet.index_count / 3;
+
+        auto const offset = shape.ibo_offset() + meshlet.index_offset;
+        if (visible_ranges_.size() > first_range && visible_ranges_.back().offset_count + visible_ranges_.back().index_count == offset) {
+            visible_ranges_.back().index_count += meshlet.index_count;
+        } else {
+            visible_ranges_.push_back({offset, meshlet.index_count});
+        }
+    }
+    draw_base_vertices_.resize(visible_ranges_.size(), base_vertex);
+
+    std::chrono::duration<double> const culling_time = std::chrono::steady_clock::now() - culling_start;
+    culling_stats_.time_ms += culling_time.count() * 1000.0;
+}
+
+void Scene::draw_shape(ShapeUniforms const& uniforms, Shape const& shape, size_t level)
+{
+    uniforms.position_offset.set(shape.quantization().offset);
+    uniforms.position_scale.set(shape.quantization().scale);
+
+    auto const base_vertex = stream_base_vertex(shape);
+    if (base_vertex) {
+        use_stream_vbo();
+    } else {
+        use_vbo();
+    }
+
+    visible_ranges_.clear();
+    draw_base_vertices_.clear();
+    cull_shape(shape, level, base_vertex.value_or(shape.vbo_offset()));
+    if (!visible_ranges_.empty()) {
+        draw_multi_indices(visible_ranges_, draw_base_vertices_);
+    }
 }
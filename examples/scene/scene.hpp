@@ -1,15 +1,29 @@
 #ifndef EXAMPLES_CUBE_HPP
 #define EXAMPLES_CUBE_HPP
 
+#include <cstdint>
+#include <exception>
+#include <future>
 #include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
 #include "../../playground/application.hpp"
 #include "../../playground/program.hpp"
+#include "../../playground/resource_manager.hpp"
 #include "../../playground/texture.hpp"
+#include "../../playground/texture_array.hpp"
+#include "../../playground/texture_atlas.hpp"
+#include "../../playground/texture_residency.hpp"
+#include "../../playground/texture_streamer.hpp"
+#include "../../playground/thread_pool.hpp"
 #include "shapes/cuboid.hpp"
+#include "shapes/mapped_shape.hpp"
 #include "shapes/sphere.hpp"
 #include "shapes/static_shape.hpp"
 #include "materials.hpp"
@@ -25,34 +39,182 @@ public:
     void scroll_mouse(int val) override;
 
 private:
-    std::unique_ptr<playground::Program> program_{};
-    std::unique_ptr<playground::Program> light_program_{};
+    struct CullingStats {
+        size_t meshlets{};
+        size_t visible_meshlets{};
+        size_t triangles{};
+        size_t visible_triangles{};
+        double time_ms{};
+    };
+
+    // pages of an atlas are layers of texture arrays, shared through the resource manager,
+    // the layers go back to the residency and the pool once the last user drops them
+    struct AtlasPages {
+        AtlasPages(playground::TextureArrayPool& arrays, playground::TextureResidency& residency) :
+          arrays{arrays}, residency{residency} {}
+        AtlasPages(AtlasPages const&) = delete;
+        AtlasPages& operator=(AtlasPages const&) = delete;
+        ~AtlasPages();
+
+        playground::TextureArrayPool& arrays;
+        playground::TextureResidency& residency;
+        std::vector<playground::TextureLayer> layers{};
+        std::vector<playground::AtlasRegion> regions{};
+    };
+
+    // the bound array is tracked within a frame
+    struct AtlasTextures {
+        std::string key{}; // of the pages, the cache path of the atlas
+        std::unique_ptr<playground::AtlasLoader> loading{};
+        std::shared_ptr<AtlasPages const> pages{};
+        GLuint bound_array{};
+    };
+
+    // the data of an object for its draws, laid out as `Object` in vertex.glsl
+    struct ObjectRecord {
+        glm::vec4 position_offset{0.0F};
+        glm::vec4 position_scale{1.0F};
+        glm::vec4 diffuse_uv_rect{0.0F, 0.0F, 1.0F, 1.0F};
+        glm::vec4 specular_uv_rect{0.0F, 0.0F, 1.0F, 1.0F};
+        glm::vec4 ambient{0.0F};
+        glm::vec4 diffuse{0.0F};
+        glm::vec4 specular_shininess{0.0F};
+        glm::ivec4 layers{0}; // of the diffuse and the specular page
+    };
+
+    // consecutive draws issued by one call, they share the vertex buffer and the texture arrays
+    struct DrawBatch {
+        std::pair<GLuint, GLuint> arrays{};
+        size_t image{}; // binds the arrays
+        bool dynamic{};
+        size_t first_draw{};
+        size_t draw_count{};
+    };
+
+    // handles of the uniforms set every frame, resolved once the programs are linked
+    struct ShapeUniforms {
+        playground::Uniform<glm::vec3> position_offset{};
+        playground::Uniform<glm::vec3> position_scale{};
+    };
+
+    struct ObjectUniforms {
+        playground::Uniform<glm::mat4> view{};
+        playground::Uniform<glm::mat4> proj{};
+        playground::Uniform<glm::mat4> model{};
+        playground::Uniform<glm::vec3> light_position{};
+        playground::Uniform<glm::vec3> camera_position{};
+        playground::Uniform<bool> octahedral_normals{};
+        playground::Uniform<GLint> diffuse_texture{};
+        playground::Uniform<GLint> specular_texture{};
+        playground::Uniform<GLint> first_draw{};
+    };
+
+    struct LightUniforms {
+        playground::Uniform<glm::mat4> view{};
+        playground::Uniform<glm::mat4> proj{};
+        playground::Uniform<glm::mat4> model{};
+        ShapeUniforms shape{};
+    };
+
+    // textures are uploaded in the background, at most this many bytes per frame.
+    // Atlas pages in the resource manager release their layers into these, so they outlive it
+    playground::TextureStreamer texture_streamer_{4UL * 1024UL * 1024UL};
+    playground::TextureResidency texture_residency_{texture_streamer_, 16UL * 1024UL * 1024UL};
+    playground::TextureArrayPool diffuse_arrays_{8, GL_TEXTURE0};
+    playground::TextureArrayPool specular_arrays_{8, GL_TEXTURE1};
+
+    // declared before everything holding its resources and before the loader pool running on it
+    playground::ResourceManager resources_{{512UL * 1024UL * 1024UL, 256UL * 1024UL * 1024UL}};
+
+    std::shared_ptr<playground::Program> program_{};
+    std::shared_ptr<playground::Program> light_program_{};
+    ObjectUniforms object_uniforms_{};
+    LightUniforms light_uniforms_{};
 
     Sphere light_{1, false};
     Sphere sphere1_{2, true};
     Sphere sphere2_{2, false};
     Cuboid cube_{};
     Cuboid floor_{};
-    playground::Texture white_pixel_diffuse_{1, 1, 3, GL_TEXTURE0};
-    playground::Texture white_pixel_specular_{1, 1, 1, GL_TEXTURE1};
-    playground::Texture cube_diffuse_{256, 256, 3, GL_TEXTURE0};
-    playground::Texture cube_specular_{256, 256, 1, GL_TEXTURE1};
+    AtlasTextures diffuse_atlas_{};
+    AtlasTextures specular_atlas_{};
+    size_t texture_binds_{};
+    size_t object_draw_calls_{};
     StaticShape bunny_{};
     std::unique_ptr<StaticShape const> bunny_prototype_{};
+    playground::ThreadPool loader_pool_{};
+    std::future<StaticShape> bunny_loading_{};
+    // a model over the memory limit is drawn from its mapped cache instead of the bunny
+    MappedShape mapped_model_{};
+    std::future<MappedShape> mapped_model_loading_{};
     std::vector<Shape*> shapes_{};
-    std::vector<uint32_t> indices_{};
+    // shapes changing from frame to frame are drawn from the stream VBO at these base vertices
+    std::vector<std::pair<Shape*, size_t>> dynamic_shapes_{};
+    bool dynamic_shapes_changed_{false};
     float scale_{1.0F};
     float camera_zoom_{glm::quarter_pi<float>()};
     float lens_shift_{};
+    float lod_pixel_error_{1.0F};
+    VertexFormat vertex_format_{VertexFormat::Packed};
+    playground::TextureFilter texture_filter_{playground::TextureFilter::Trilinear};
+    playground::CaptureFormat capture_format_{playground::CaptureFormat::Png};
+    float max_position_error_{1e-3F};
+    bool meshlet_culling_{true};
+    Frustum culling_frustum_{};
+    glm::vec3 culling_camera_position_{0.0F};
+    CullingStats culling_stats_{};
+    // the draws of a frame, a visible range of the IBO each
+    std::vector<IndexRange> visible_ranges_{};
+    std::vector<size_t> draw_base_vertices_{};
+    std::vector<uint32_t> draw_objects_{};
+    std::vector<ObjectRecord> object_records_{};
+    std::vector<DrawBatch> draw_batches_{};
+    size_t bunny_lod_{};
     glm::vec3 camera_position_{0.0F, 0.0F, 5.0F};
     glm::vec2 camera_rotation_{0.0F, 0.0F};
     glm::vec2 world_rotation_{20.0F, 0.0F};
     glm::vec3 light_position_{-2.0F, 3.5F, 5.0F};
 
+    void load_atlas(AtlasTextures& textures, playground::TextureArrayPool& arrays);
+
+    std::pair<GLuint, GLuint> atlas_arrays(size_t image) const;
+
+    void bind_atlas_arrays(size_t image);
+
+    ObjectRecord object_record(Shape const& shape, size_t image, materials::Material const& material) const;
+
+    void write_draw_storage();
+
+    void render_objects(glm::mat4 const& view, glm::mat4 const& proj, glm::vec3 const& camera_position);
+
+    void request_texture_levels(Shape const& shape, size_t image, glm::mat4 const& view, glm::mat4 const& proj);
+
+    std::shared_ptr<playground::Program> load_program(std::string const& vertex_path, std::string const& fragment_path);
+
+    void resolve_uniforms();
+
     glm::mat4 view_matrix();
     glm::mat4 proj_matrix();
 
-    void set_material(materials::Material const& material);
+    void upload_vertices();
+
+    void upload_shape_vertices(Shape& shape);
+
+    void write_dynamic_vertices();
+
+    void use_float_vertices(std::exception const& packing_error);
+
+    void upload_indices();
+
+    size_t select_lod(Shape const& shape, glm::vec3 center, float radius, glm::mat4 const& view, glm::mat4 const& proj);
+
+    void set_culling_transform(glm::mat4 const& view, glm::mat4 const& proj, glm::mat4 const& model);
+
+    std::optional<size_t> stream_base_vertex(Shape const& shape) const;
+
+    void cull_shape(Shape const& shape, size_t level, size_t base_vertex);
+
+    void draw_shape(ShapeUniforms const& uniforms, Shape const& shape, size_t level = 0);
 };
 
 #endif // EXAMPLES_CUBE_HPP
@@ -55,7 +55,8 @@ static std::vector<Vertex> create_unit_cube()
 }
 
 Cuboid::Cuboid() :
-  vertices_{create_unit_cube()} {}
+  unit_cube_{weld_vertices(create_unit_cube())},
+  vertices_{unit_cube_.vertices} {}
 
 void Cuboid::set_position(glm::vec3 position)
 {
@@ -91,11 +92,13 @@ void Cuboid::set_dimensions(float width, float height, float depth)
 
 void Cuboid::update()
 {
-    auto unit = create_unit_cube();
+    auto const& unit = unit_cube_.vertices;
     std::transform(unit.cbegin(), unit.cend(), vertices_.begin(), [this](Vertex v) {
         v.position.x = v.position.x * width_ + position_.x;
         v.position.y = v.position.y * height_ + position_.y;
         v.position.z = v.position.z * depth_ + position_.z;
         return v;
     });
+
+    update_meshlets();
 }
@@ -28,9 +28,14 @@ public:
 
     [[nodiscard]] Vertex const* vbo_data() const override { return vertices_.data(); }
 
+    [[nodiscard]] size_t index_count() const override { return unit_cube_.indices.size(); }
+
+    [[nodiscard]] uint32_t const* ibo_data() const override { return unit_cube_.indices.data(); }
+
     void update() override;
 
 private:
+    IndexedVertices unit_cube_{};
     std::vector<Vertex> vertices_{};
 
     glm::vec3 position_{0.0F};
@@ -0,0 +1,39 @@
+#include "mapped_shape.hpp"
+
+MappedShape::MappedShape(std::shared_ptr<MappedVertexModel const> model) :
+  model_{std::move(model)} {}
+
+MeshLod MappedShape::lod(size_t level) const
+{
+    if (!model_ || model_->lods.empty()) {
+        return Shape::lod(level);
+    }
+    return model_->lods.at(level);
+}
+
+std::pair<glm::vec3, glm::vec3> MappedShape::vertex_bounds() const
+{
+    return model_ ? std::pair{model_->min_bound, model_->max_bound} : Shape::vertex_bounds();
+}
+
+glm::vec3 MappedShape::bounds_center() const
+{
+    return model_ ? (model_->min_bound + model_->max_bound) * 0.5F : glm::vec3{0.0F};
+}
+
+float MappedShape::bounds_radius() const
+{
+    return model_ ? glm::length(model_->max_bound - model_->min_bound) * 0.5F : 0.0F;
+}
+
+void MappedShape::update()
+{
+    clear_meshlets();
+}
+
+std::future<MappedShape> map_shape_async(playground::ThreadPool& pool, std::string file_path, LoadOptions options)
+{
+    return pool.submit([file_path = std::move(file_path), options]() {
+        return MappedShape{std::make_shared<MappedVertexModel const>(map_vertex_model(file_path, options))};
+    });
+}
@@ -0,0 +1,56 @@
+#ifndef PLAYGROUND_MAPPED_SHAPE_HPP
+#define PLAYGROUND_MAPPED_SHAPE_HPP
+
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "../../../playground/thread_pool.hpp"
+#include "../mesh_cache.hpp"
+#include "shape.hpp"
+
+/*******************************************************************************
+ * a model mapped from its cache, e.g. one over the memory limit. Vertices and
+ * indices are read straight from the mapping while they are uploaded, so the
+ * model is never in the process memory as a whole. Such models are too large
+ * to be clustered or scaled on the CPU, they have no meshlets and keep the
+ * size of the file
+ ******************************************************************************/
+class MappedShape : public Shape {
+public:
+    MappedShape() = default;
+    explicit MappedShape(std::shared_ptr<MappedVertexModel const> model);
+
+    [[nodiscard]] size_t vertex_count() const override { return model_ ? model_->vertices.size() : 0; }
+
+    [[nodiscard]] Vertex const* vbo_data() const override { return model_ ? model_->vertices.data() : nullptr; }
+
+    [[nodiscard]] size_t index_count() const override { return model_ ? model_->indices.size() : 0; }
+
+    [[nodiscard]] uint32_t const* ibo_data() const override { return model_ ? model_->indices.data() : nullptr; }
+
+    [[nodiscard]] size_t lod_count() const override { return model_ && !model_->lods.empty() ? model_->lods.size() : 1; }
+
+    [[nodiscard]] MeshLod lod(size_t level) const override;
+
+    // the bounds recorded in the cache, packing the vertices needs no extra pass over them
+    [[nodiscard]] std::pair<glm::vec3, glm::vec3> vertex_bounds() const override;
+
+    // the sphere around the bounds of the model
+    [[nodiscard]] glm::vec3 bounds_center() const;
+    [[nodiscard]] float bounds_radius() const;
+
+    void update() override;
+
+private:
+    std::shared_ptr<MappedVertexModel const> model_{};
+};
+
+/*******************************************************************************
+ * converts the model into its mapped cache, unless it is baked already, and
+ * maps it on a thread of the pool, see `map_vertex_model`
+ ******************************************************************************/
+std::future<MappedShape> map_shape_async(playground::ThreadPool& pool, std::string file_path, LoadOptions options = {});
+
+#endif // PLAYGROUND_MAPPED_SHAPE_HPP
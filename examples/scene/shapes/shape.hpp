@@ -1,10 +1,17 @@
 #ifndef PLAYGROUND_SHAPE_HPP
 #define PLAYGROUND_SHAPE_HPP
 
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <span>
+#include <utility>
+#include <vector>
 
 #include <glm/vec3.hpp>
 
+#include "../meshlets.hpp"
+#include "../packed_vertex.hpp"
 #include "../vertex.hpp"
 
 class Shape {
@@ -20,6 +27,32 @@ public:
 
     [[nodiscard]] virtual Vertex const* vbo_data() const = 0;
 
+    [[nodiscard]] virtual size_t index_count() const = 0;
+
+    // indices are local to the shape, i.e. the first vertex of the shape has index 0
+    [[nodiscard]] virtual uint32_t const* ibo_data() const = 0;
+
+    // levels of detail are ranges of the shape's indices, level 0 is the full resolution;
+    // shapes without simplified levels draw all of their indices
+    [[nodiscard]] virtual size_t lod_count() const { return 1; }
+    [[nodiscard]] virtual MeshLod lod([[maybe_unused]] size_t level) const { return {0, index_count(), 0.0F}; }
+
+    // meshlets of every level of detail, offsets are relative to the shape's indices;
+    // shapes too large to be clustered have none and are drawn without culling
+    [[nodiscard]] std::vector<Meshlet> const& meshlets(size_t level) const { return meshlets_.at(level); }
+
+    // the box around all vertices, shapes knowing it beforehand spare the pass over their vertices
+    [[nodiscard]] virtual std::pair<glm::vec3, glm::vec3> vertex_bounds() const
+    {
+        glm::vec3 min_bound{std::numeric_limits<float>::max()};
+        glm::vec3 max_bound{std::numeric_limits<float>::lowest()};
+        for (auto const& vertex : std::span{vbo_data(), vertex_count()}) {
+            min_bound = glm::min(min_bound, vertex.position);
+            max_bound = glm::max(max_bound, vertex.position);
+        }
+        return {min_bound, max_bound};
+    }
+
     bool needs_update() { return needs_update_; };
 
     virtual void update() = 0;
@@ -29,11 +62,63 @@ public:
     [[nodiscard]] size_t vbo_offset() const { return vbo_offset_; }
     void set_vbo_offset(size_t vbo_offset_bytes) { vbo_offset_ = vbo_offset_bytes; }
 
+    [[nodiscard]] size_t ibo_offset() const { return ibo_offset_; }
+    void set_ibo_offset(size_t ibo_offset) { ibo_offset_ = ibo_offset; }
+
+    [[nodiscard]] VertexQuantization const& quantization() const { return quantization_; }
+    void set_quantization(VertexQuantization const& quantization) { quantization_ = quantization; }
+
 protected:
     void set_needs_update() { needs_update_ = true; };
 
+    // meshlets of every level of detail, offsets are relative to `indices`
+    static std::vector<std::vector<Meshlet>> build_lod_meshlets(
+      std::span<Vertex const> vertices, std::span<uint32_t const> indices, std::span<MeshLod const> lods)
+    {
+        std::vector<std::vector<Meshlet>> res(lods.size());
+        for (size_t level = 0; level < lods.size(); ++level) {
+            auto const& range = lods[level];
+            res[level] = build_meshlets(vertices, indices.subspan(range.index_offset, range.index_count));
+            for (auto& meshlet : res[level]) {
+                meshlet.index_offset += range.index_offset;
+            }
+        }
+        return res;
+    }
+
+    // rebuilds meshlets from the current vertices, call at the end of `update`
+    void update_meshlets()
+    {
+        std::vector<MeshLod> lods(lod_count());
+        for (size_t level = 0; level < lods.size(); ++level) {
+            lods[level] = lod(level);
+        }
+        meshlets_ = build_lod_meshlets({vbo_data(), vertex_count()}, {ibo_data(), index_count()}, lods);
+    }
+
+    // leaves every level without meshlets, call at the end of `update`
+    void clear_meshlets() { meshlets_.assign(lod_count(), {}); }
+
+    /*
+     * the same meshlets as `update_meshlets` builds for the vertices scaled uniformly by `scale`,
+     * a uniform scale keeps the clusters and their cones, it moves and sizes their bounds only
+     */
+    void scale_meshlets(std::vector<std::vector<Meshlet>> const& meshlets, float scale)
+    {
+        meshlets_ = meshlets;
+        for (auto& level : meshlets_) {
+            for (auto& meshlet : level) {
+                meshlet.center *= scale;
+                meshlet.radius *= scale;
+            }
+        }
+    }
+
 private:
     size_t vbo_offset_{};
+    size_t ibo_offset_{};
+    VertexQuantization quantization_{};
+    std::vector<std::vector<Meshlet>> meshlets_{};
     bool needs_update_{true};
 };
 
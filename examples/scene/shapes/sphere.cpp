@@ -78,13 +78,21 @@ static void smoothen(std::vector<Vertex>& vertices)
 Sphere::Sphere() :
   Sphere(0, false) {}
 
-Sphere::Sphere(size_t degree, bool smooth) :
-  unit_icosahedron_{create_unit_icosahedron(degree)},
-  vertices_{unit_icosahedron_}
+// a smooth sphere shares vertices between all adjacent polygons,
+// a flat one only between polygons of the same refined face
+static IndexedVertices create_indexed_icosahedron(size_t degree, bool smooth)
 {
+    auto vertices = create_unit_icosahedron(degree);
     if (smooth) {
-        smoothen(unit_icosahedron_);
+        smoothen(vertices);
     }
+    return weld_vertices(vertices);
+}
+
+Sphere::Sphere(size_t degree, bool smooth) :
+  unit_icosahedron_{create_indexed_icosahedron(degree, smooth)},
+  vertices_{unit_icosahedron_.vertices}
+{
 }
 
 void Sphere::set_position(glm::vec3 position)
@@ -101,8 +109,11 @@ void Sphere::set_size(float size)
 
 void Sphere::update()
 {
-    std::transform(unit_icosahedron_.cbegin(), unit_icosahedron_.cend(), vertices_.begin(), [this](Vertex v) {
+    auto const& unit = unit_icosahedron_.vertices;
+    std::transform(unit.cbegin(), unit.cend(), vertices_.begin(), [this](Vertex v) {
         v.position = v.position * size_ + position_;
         return v;
     });
+
+    update_meshlets();
 }
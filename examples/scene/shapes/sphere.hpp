@@ -21,10 +21,14 @@ public:
 
     [[nodiscard]] Vertex const* vbo_data() const override { return vertices_.data(); }
 
+    [[nodiscard]] size_t index_count() const override { return unit_icosahedron_.indices.size(); }
+
+    [[nodiscard]] uint32_t const* ibo_data() const override { return unit_icosahedron_.indices.data(); }
+
     void update() override;
 
 private:
-    std::vector<Vertex> unit_icosahedron_{};
+    IndexedVertices unit_icosahedron_{};
     std::vector<Vertex> vertices_{};
 
     glm::vec3 position_{0.0F};
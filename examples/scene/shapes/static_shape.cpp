@@ -1,14 +1,28 @@
 #include "static_shape.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <limits>
 
 #include <glm/gtx/io.hpp>
 #include <spdlog/spdlog.h>
 
 StaticShape::StaticShape(std::shared_ptr<VertexModel const> model) :
-  model_{std::move(model)} {}
+  model_{std::move(model)}
+{
+    // clustering is the costly part of meshlets, it is done once per model,
+    // on the loading thread, and the clusters are only scaled by `update`
+    if (model_) {
+        std::vector<MeshLod> lods(lod_count());
+        for (size_t level = 0; level < lods.size(); ++level) {
+            lods[level] = lod(level);
+        }
+        model_meshlets_ = std::make_shared<std::vector<std::vector<Meshlet>> const>(
+          build_lod_meshlets(model_->vertices, model_->indices, lods));
+    }
+}
 
 void StaticShape::set_scale(float scale)
 {
@@ -19,10 +33,37 @@ void StaticShape::set_scale(float scale)
 void StaticShape::update()
 {
     vertices_.clear();
-    vertices_.reserve(model_->size());
-    std::transform(model_->cbegin(), model_->cend(), std::back_inserter(vertices_),
-      [scale = scale_](Vertex vertex) {
-          vertex.position *= scale;
-          return vertex;
-      });
+
+    // a shape without a model, e.g. one which is still loading, has nothing to draw
+    if (model_) {
+        vertices_.reserve(model_->vertices.size());
+        std::transform(model_->vertices.cbegin(), model_->vertices.cend(), std::back_inserter(vertices_),
+          [scale = scale_](Vertex vertex) {
+              vertex.position *= scale;
+              return vertex;
+          });
+        scale_meshlets(*model_meshlets_, scale_);
+    } else {
+        update_meshlets();
+    }
+}
+
+MeshLod StaticShape::lod(size_t level) const
+{
+    if (!model_ || model_->lods.empty()) {
+        return Shape::lod(level);
+    }
+    auto res = model_->lods.at(level);
+    res.error *= scale_;
+    return res;
+}
+
+glm::vec3 StaticShape::bounds_center() const
+{
+    return model_ ? (model_->min_bound + model_->max_bound) * 0.5F * scale_ : glm::vec3{0.0F};
+}
+
+float StaticShape::bounds_radius() const
+{
+    return model_ ? glm::length(model_->max_bound - model_->min_bound) * 0.5F * scale_ : 0.0F;
 }
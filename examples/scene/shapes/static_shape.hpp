@@ -22,7 +22,20 @@ public:
 
     [[nodiscard]] Vertex const* vbo_data() const override { return vertices_.data(); }
 
-    [[nodiscard]]  float scale() { return scale_; }
+    [[nodiscard]] size_t index_count() const override { return model_ ? model_->indices.size() : 0; }
+
+    [[nodiscard]] uint32_t const* ibo_data() const override { return model_ ? model_->indices.data() : nullptr; }
+
+    [[nodiscard]] size_t lod_count() const override { return model_ && !model_->lods.empty() ? model_->lods.size() : 1; }
+
+    // errors are scaled along with the shape
+    [[nodiscard]] MeshLod lod(size_t level) const override;
+
+    // the sphere around the scaled bounds of the model
+    [[nodiscard]] glm::vec3 bounds_center() const;
+    [[nodiscard]] float bounds_radius() const;
+
+    [[nodiscard]] float scale() const { return scale_; }
     void set_scale(float scale);
 
     void update() override;
@@ -31,6 +44,8 @@ private:
     float scale_{1.0};
     std::vector<Vertex> vertices_{};
     std::shared_ptr<VertexModel const> model_{};
+    // of the unscaled model, shared by the copies of the shape
+    std::shared_ptr<std::vector<std::vector<Meshlet>> const> model_meshlets_{};
 };
 
 #endif // PLAYGROUND_STATIC_SHAPE_HPP
@@ -0,0 +1,338 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <queue>
+#include <span>
+#include <unordered_map>
+
+#include "../../playground/hash.hpp"
+#include "simplify.hpp"
+
+// boundary edges are kept in place by planes perpendicular to their triangles,
+// weighted, so open borders erode only after the interior is simplified
+static double const boundary_weight = 10.0;
+
+/*******************************************************************************
+ * symmetric 4x4 matrix of the sum of squared distances to a set of planes,
+ * only the upper triangle is stored
+ ******************************************************************************/
+struct Quadric {
+    std::array<double, 10> m{};
+    double weight{};
+
+    void add_plane(glm::dvec3 const& normal, double distance, double plane_weight)
+    {
+        auto const a = normal.x;
+        auto const b = normal.y;
+        auto const c = normal.z;
+        auto const d = distance;
+        std::array<double, 10> const plane{a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d};
+        for (size_t i = 0; i < m.size(); ++i) {
+            m[i] += plane[i] * plane_weight;
+        }
+        weight += plane_weight;
+    }
+
+    Quadric& operator+=(Quadric const& other)
+    {
+        for (size_t i = 0; i < m.size(); ++i) {
+            m[i] += other.m[i];
+        }
+        weight += other.weight;
+        return *this;
+    }
+
+    // weighted mean of the squared distances from the point to the planes
+    [[nodiscard]] double evaluate(glm::dvec3 const& p) const
+    {
+        auto const x = p.x;
+        auto const y = p.y;
+        auto const z = p.z;
+        auto const sum = m[0] * x * x + 2 * m[1] * x * y + 2 * m[2] * x * z + 2 * m[3] * x
+          + m[4] * y * y + 2 * m[5] * y * z + 2 * m[6] * y
+          + m[7] * z * z + 2 * m[8] * z
+          + m[9];
+        return weight > 0.0 ? std::max(sum, 0.0) / weight : 0.0;
+    }
+};
+
+struct Collapse {
+    double cost{};
+    uint32_t from{};
+    uint32_t to{};
+    uint32_t from_version{};
+    uint32_t to_version{};
+
+    bool operator>(Collapse const& other) const { return cost > other.cost; }
+};
+
+using Triangle = std::array<uint32_t, 3>;
+
+/*******************************************************************************
+ * state of the simplification, all vertices here are unique positions
+ ******************************************************************************/
+class Simplifier {
+public:
+    Simplifier(std::vector<glm::dvec3> positions, std::vector<Triangle> triangles) :
+      positions_{std::move(positions)},
+      triangles_{std::move(triangles)},
+      alive_(triangles_.size(), true),
+      live_triangles_{triangles_.size()},
+      adjacent_(positions_.size()),
+      quadrics_(positions_.size()),
+      versions_(positions_.size()),
+      collapsed_(positions_.size(), false)
+    {
+        std::unordered_map<uint64_t, uint32_t> edge_uses{};
+        for (uint32_t t = 0; t < triangles_.size(); ++t) {
+            auto const& [a, b, c] = triangles_[t];
+            if (a == b || b == c || c == a) {
+                alive_[t] = false; // already degenerate, it has no edges to collapse
+                --live_triangles_;
+                continue;
+            }
+            for (auto v : triangles_[t]) {
+                adjacent_[v].push_back(t);
+            }
+            for (size_t i = 0; i < 3; ++i) {
+                ++edge_uses[edge_key(triangles_[t][i], triangles_[t][(i + 1) % 3])];
+            }
+        }
+
+        for (size_t t = 0; t < triangles_.size(); ++t) {
+            if (alive_[t]) {
+                add_triangle_quadrics(triangles_[t], edge_uses);
+            }
+        }
+
+        for (auto const& [key, uses] : edge_uses) {
+            push_collapse(static_cast<uint32_t>(key >> 32U), static_cast<uint32_t>(key));
+        }
+    }
+
+    // collapses edges until the goal is reached, returns the largest error of a collapse
+    double run(size_t target_triangle_count, double max_error)
+    {
+        double error = 0.0;
+        while (live_triangles_ > target_triangle_count && !collapses_.empty()) {
+            auto const collapse = collapses_.top();
+            collapses_.pop();
+
+            if (collapsed_[collapse.from] || collapsed_[collapse.to]
+              || versions_[collapse.from] != collapse.from_version || versions_[collapse.to] != collapse.to_version) {
+                continue; // either end has changed since the collapse was queued
+            }
+
+            auto const collapse_error = std::sqrt(collapse.cost);
+            if (collapse_error > max_error) {
+                break;
+            }
+
+            if (!keeps_orientation(collapse.from, collapse.to)) {
+                continue;
+            }
+
+            apply(collapse.from, collapse.to);
+            error = std::max(error, collapse_error);
+        }
+        return error;
+    }
+
+    [[nodiscard]] std::vector<Triangle> const& triangles() const { return triangles_; }
+    [[nodiscard]] bool is_alive(size_t triangle) const { return alive_[triangle]; }
+
+private:
+    std::vector<glm::dvec3> positions_;
+    std::vector<Triangle> triangles_;
+    std::vector<bool> alive_;
+    size_t live_triangles_;
+    std::vector<std::vector<uint32_t>> adjacent_; // triangles around every vertex
+    std::vector<Quadric> quadrics_;
+    std::vector<uint32_t> versions_; // incremented whenever a quadric changes
+    std::vector<bool> collapsed_;
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>> collapses_{};
+
+    static uint64_t edge_key(uint32_t a, uint32_t b)
+    {
+        return (static_cast<uint64_t>(std::min(a, b)) << 32U) | std::max(a, b);
+    }
+
+    void add_triangle_quadrics(Triangle const& triangle, std::unordered_map<uint64_t, uint32_t> const& edge_uses)
+    {
+        auto const& a = positions_[triangle[0]];
+        auto const& b = positions_[triangle[1]];
+        auto const& c = positions_[triangle[2]];
+        auto const cross = glm::cross(b - a, c - a);
+        auto const double_area = glm::length(cross);
+        if (double_area == 0.0) {
+            return;
+        }
+
+        auto const normal = cross / double_area;
+        for (auto v : triangle) {
+            quadrics_[v].add_plane(normal, -glm::dot(normal, a), double_area * 0.5);
+        }
+
+        for (size_t i = 0; i < 3; ++i) {
+            auto const from = triangle[i];
+            auto const to = triangle[(i + 1) % 3];
+            if (edge_uses.at(edge_key(from, to)) != 1) {
+                continue;
+            }
+            auto const edge = positions_[to] - positions_[from];
+            auto const edge_length = glm::length(edge);
+            if (edge_length == 0.0) {
+                continue;
+            }
+            auto const border_normal = glm::cross(edge, normal) / edge_length;
+            auto const distance = -glm::dot(border_normal, positions_[from]);
+            auto const plane_weight = edge_length * edge_length * boundary_weight;
+            quadrics_[from].add_plane(border_normal, distance, plane_weight);
+            quadrics_[to].add_plane(border_normal, distance, plane_weight);
+        }
+    }
+
+    // queues the cheaper direction of collapsing the edge
+    void push_collapse(uint32_t a, uint32_t b)
+    {
+        auto quadric = quadrics_[a];
+        quadric += quadrics_[b];
+        auto const to_b = quadric.evaluate(positions_[b]);
+        auto const to_a = quadric.evaluate(positions_[a]);
+        if (to_b <= to_a) {
+            collapses_.push({to_b, a, b, versions_[a], versions_[b]});
+        } else {
+            collapses_.push({to_a, b, a, versions_[b], versions_[a]});
+        }
+    }
+
+    // moving `from` onto `to` must not turn any remaining triangle around
+    bool keeps_orientation(uint32_t from, uint32_t to) const
+    {
+        for (auto t : adjacent_[from]) {
+            auto const& triangle = triangles_[t];
+            if (!alive_[t] || std::find(triangle.cbegin(), triangle.cend(), to) != triangle.cend()) {
+                continue; // the triangle disappears with the collapse
+            }
+
+            std::array<glm::dvec3, 3> corners{};
+            for (size_t i = 0; i < 3; ++i) {
+                corners[i] = positions_[triangle[i]];
+            }
+            auto const before = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+
+            for (size_t i = 0; i < 3; ++i) {
+                if (triangle[i] == from) {
+                    corners[i] = positions_[to];
+                }
+            }
+            auto const after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+
+            if (glm::dot(before, after) <= 0.0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void apply(uint32_t from, uint32_t to)
+    {
+        collapsed_[from] = true;
+        quadrics_[to] += quadrics_[from];
+        ++versions_[to];
+
+        for (auto t : adjacent_[from]) {
+            if (!alive_[t]) {
+                continue;
+            }
+            auto& triangle = triangles_[t];
+            if (std::find(triangle.cbegin(), triangle.cend(), to) != triangle.cend()) {
+                alive_[t] = false;
+                --live_triangles_;
+                continue;
+            }
+            std::replace(triangle.begin(), triangle.end(), from, to);
+            adjacent_[to].push_back(t);
+        }
+        adjacent_[from].clear();
+
+        auto& around = adjacent_[to];
+        around.erase(std::remove_if(around.begin(), around.end(), [this](uint32_t t) { return !alive_[t]; }), around.end());
+
+        std::vector<uint32_t> neighbours{};
+        for (auto t : around) {
+            for (auto v : triangles_[t]) {
+                if (v != to) {
+                    neighbours.push_back(v);
+                }
+            }
+        }
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+        for (auto v : neighbours) {
+            push_collapse(v, to);
+        }
+    }
+};
+
+SimplifiedIndices simplify_mesh(
+  std::vector<Vertex> const& vertices,
+  std::vector<uint32_t> const& indices,
+  size_t target_index_count,
+  float max_error)
+{
+    // vertices which differ only in normals or uvs are one position for the simplification,
+    // otherwise seams between them would tear apart
+    struct PositionHash {
+        size_t operator()(glm::vec3 const& p) const
+        {
+            return playground::hash_bytes(std::as_bytes(std::span{&p, 1}));
+        }
+    };
+    struct PositionEqual {
+        bool operator()(glm::vec3 const& a, glm::vec3 const& b) const
+        {
+            return std::memcmp(&a, &b, sizeof(glm::vec3)) == 0;
+        }
+    };
+
+    std::unordered_map<glm::vec3, uint32_t, PositionHash, PositionEqual> unique_positions{};
+    std::vector<glm::dvec3> positions{};
+    std::vector<uint32_t> position_of(vertices.size());
+    std::vector<uint32_t> first_vertex{}; // the vertex used for a position that replaces another one
+    for (uint32_t v = 0; v < vertices.size(); ++v) {
+        auto [it, inserted] = unique_positions.try_emplace(vertices[v].position, static_cast<uint32_t>(positions.size()));
+        if (inserted) {
+            positions.emplace_back(vertices[v].position);
+            first_vertex.push_back(v);
+        }
+        position_of[v] = it->second;
+    }
+
+    std::vector<Triangle> triangles{};
+    triangles.reserve(indices.size() / 3);
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        triangles.push_back({position_of[indices[i]], position_of[indices[i + 1]], position_of[indices[i + 2]]});
+    }
+
+    Simplifier simplifier{std::move(positions), std::move(triangles)};
+    auto const error = simplifier.run(target_index_count / 3, static_cast<double>(max_error));
+
+    // remaining triangles keep their order and, where possible, their original vertices
+    SimplifiedIndices res{};
+    res.error = static_cast<float>(error);
+    auto const& simplified = simplifier.triangles();
+    for (size_t t = 0; t < simplified.size(); ++t) {
+        if (!simplifier.is_alive(t)) {
+            continue;
+        }
+        for (size_t i = 0; i < 3; ++i) {
+            auto const original = indices[t * 3 + i];
+            auto const position = simplified[t][i];
+            res.indices.push_back(position_of[original] == position ? original : first_vertex[position]);
+        }
+    }
+
+    return res;
+}
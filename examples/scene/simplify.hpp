@@ -0,0 +1,35 @@
+#ifndef PLAYGROUND_SIMPLIFY_HPP
+#define PLAYGROUND_SIMPLIFY_HPP
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "vertex.hpp"
+
+/*******************************************************************************
+ * indices of a simplified mesh and the largest geometric deviation,
+ * in model units, introduced by the simplification
+ ******************************************************************************/
+struct SimplifiedIndices {
+    std::vector<uint32_t> indices{};
+    float error{};
+};
+
+/*******************************************************************************
+ * reduces the number of triangles with edge collapses ordered by the
+ * quadric error metric (Garland and Heckbert 1997).
+ * Vertices are collapsed onto other existing vertices, so the result indexes
+ * the same vertex buffer and can share it with the original mesh.
+ * Vertices with equal positions but different normals or uvs are simplified
+ * as one. Collapses stop when the mesh has at most `target_index_count`
+ * indices, when the next collapse would exceed `max_error`, or when
+ * no collapse is possible without flipping a triangle
+ ******************************************************************************/
+SimplifiedIndices simplify_mesh(
+  std::vector<Vertex> const& vertices,
+  std::vector<uint32_t> const& indices,
+  size_t target_index_count,
+  float max_error = std::numeric_limits<float>::max());
+
+#endif // PLAYGROUND_SIMPLIFY_HPP
@@ -1,90 +1,311 @@
-#include <array>
-#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <limits>
 #include <numeric>
+#include <span>
 #include <stdexcept>
+#include <system_error>
+#include <unordered_map>
 
+#include <spdlog/spdlog.h>
+
+#include "../../playground/hash.hpp"
+#include "../../playground/mapped_file.hpp"
+#include "mesh_cache.hpp"
+#include "mesh_converter.hpp"
+#include "mesh_optimizer.hpp"
+#include "simplify.hpp"
 #include "vertex.hpp"
 
-static std::pair<std::vector<glm::vec3>, std::vector<glm::uvec3>> parse_wavefront_file(std::string const& file_path);
+static VertexModel build_vertex_model(std::string const& file_path, LoadOptions const& options);
+
+static uint64_t model_source_hash(std::string const& file_path, LoadOptions const& options);
+
+static uint64_t model_source_stamp(std::string const& file_path, LoadOptions const& options, bool out_of_core);
+
+static bool is_fully_indexed(std::vector<glm::uvec3> const& indices);
 
 static std::pair<glm::vec3, glm::vec3> elementwise_minmax(std::vector<glm::vec3> const& vertices);
 
-static std::vector<glm::vec3> calculate_mean_normals(
-  std::vector<glm::vec3> const& vertices,
-  std::vector<glm::uvec3> const& indices);
+VertexModel read_vertex_model(std::string const& file_path, LoadOptions const& options)
+{
+    // copying such a model into memory would defeat the memory limit it was converted within
+    if (exceeds_memory_limit(file_path, options)) {
+        throw std::runtime_error(fmt::format(
+          "`{}` exceeds the memory limit of {} bytes, it can only be mapped with `map_vertex_model`", file_path, options.memory_limit));
+    }
+
+    if (!options.use_cache) {
+        return build_vertex_model(file_path, options);
+    }
+
+    auto const source_hash = model_source_hash(file_path, options);
+    auto const cache_path = mesh_cache_path(file_path);
+
+    if (auto cached = read_mesh_cache(cache_path, source_hash)) {
+        spdlog::info("loaded baked model `{}`", cache_path);
+        return std::move(*cached);
+    }
+
+    auto model = build_vertex_model(file_path, options);
+
+    // the cache is only an optimization, failing to write it is not an error
+    try {
+        write_mesh_cache(cache_path, source_hash, model, options.cache_compression);
+    } catch (std::exception const& e) {
+        spdlog::warn("could not write mesh cache `{}`: {}", cache_path, e.what());
+    }
+
+    return model;
+}
 
-VertexModel read_vertex_model(std::string const& file_path)
+MappedVertexModel map_vertex_model(std::string const& file_path, LoadOptions const& options)
 {
-    auto [raw_vertices, raw_indices] = parse_wavefront_file(file_path);
+    auto const out_of_core = exceeds_memory_limit(file_path, options);
+    auto const source_hash = model_source_stamp(file_path, options, out_of_core);
+    auto const cache_path = mapped_mesh_cache_path(file_path);
+
+    if (auto mapped = map_mesh_cache(cache_path, source_hash)) {
+        spdlog::info("mapped baked model `{}`", cache_path);
+        return std::move(*mapped);
+    }
+
+    // the converted model never exists in memory as a whole, only in the mapped cache
+    if (out_of_core) {
+        MeshCacheSink sink{cache_path, source_hash};
+        convert_wavefront_out_of_core(file_path, sink, options.memory_limit, options.normal_weighting);
+    } else {
+        write_mesh_cache(cache_path, source_hash, build_vertex_model(file_path, options), MeshCompression::None);
+    }
+
+    if (auto mapped = map_mesh_cache(cache_path, source_hash)) {
+        return std::move(*mapped);
+    }
+    throw std::runtime_error(fmt::format("could not map the converted model `{}`", cache_path));
+}
+
+std::shared_ptr<VertexModel const> read_shared_vertex_model(
+  playground::ResourceManager& resources, std::string const& file_path, LoadOptions const& options)
+{
+    auto const key = fmt::format("{}:{}:{}:{}:{}:{}:{}:{}",
+      file_path,
+      static_cast<int>(options.parser),
+      static_cast<int>(options.normal_weighting),
+      options.optimize,
+      options.lod_count,
+      options.use_cache,
+      static_cast<int>(options.cache_compression),
+      options.memory_limit);
+
+    return resources.get<VertexModel const>(key, [&]() {
+        auto model = std::make_shared<VertexModel const>(read_vertex_model(file_path, options));
+        auto const cpu_bytes = model->vertices.size() * sizeof(Vertex)
+          + model->indices.size() * sizeof(uint32_t)
+          + model->lods.size() * sizeof(MeshLod);
+        return playground::LoadedResource<VertexModel const>{model, {cpu_bytes, 0}};
+    });
+}
+
+bool exceeds_memory_limit(std::string const& file_path, LoadOptions const& options)
+{
+    if (options.memory_limit == 0) {
+        return false;
+    }
+    // a missing file is reported by the loader
+    std::error_code error{};
+    auto const size = std::filesystem::file_size(file_path, error);
+    return !error && size > options.memory_limit;
+}
+
+// options which change the built model are a part of the key as well
+static uint64_t combine_options(uint64_t source_hash, LoadOptions const& options, bool out_of_core)
+{
+    source_hash = playground::hash_combine(source_hash, static_cast<uint64_t>(options.normal_weighting));
+    source_hash = playground::hash_combine(source_hash, static_cast<uint64_t>(options.optimize));
+    source_hash = playground::hash_combine(source_hash, options.lod_count);
+    source_hash = playground::hash_combine(source_hash, static_cast<uint64_t>(out_of_core));
+    return source_hash;
+}
+
+/*******************************************************************************
+ * hashing the mapped file is an order of magnitude faster than parsing it
+ ******************************************************************************/
+static uint64_t model_source_hash(std::string const& file_path, LoadOptions const& options)
+{
+    return combine_options(playground::hash_bytes(playground::MappedFile{file_path}.bytes()), options, false);
+}
+
+/*******************************************************************************
+ * files which are mapped may be far larger than the memory, reading all of
+ * them on every load would take as long as the load itself. The size and the
+ * modification time of the file stand in for its contents instead
+ ******************************************************************************/
+static uint64_t model_source_stamp(std::string const& file_path, LoadOptions const& options, bool out_of_core)
+{
+    auto const size = std::filesystem::file_size(file_path);
+    auto const modified = std::filesystem::last_write_time(file_path).time_since_epoch().count();
+    auto const stamp = playground::hash_combine(size, static_cast<uint64_t>(modified));
+    return combine_options(stamp, options, out_of_core);
+}
+
+/*******************************************************************************
+ * parses the source file and builds the final model from scratch
+ ******************************************************************************/
+VertexModel build_vertex_model(std::string const& file_path, LoadOptions const& options)
+{
+    auto const parse_start = std::chrono::steady_clock::now();
+    auto mesh = parse_wavefront_file(file_path, options.parser);
+    std::chrono::duration<double> const parse_time = std::chrono::steady_clock::now() - parse_start;
+
+    auto const file_megabytes = static_cast<double>(std::filesystem::file_size(file_path)) / (1024.0 * 1024.0);
+    spdlog::info("parsed `{}` in {:.1f} ms, {:.1f} MB/s",
+      file_path, parse_time.count() * 1000.0, file_megabytes / parse_time.count());
+
+    auto const& raw_vertices = mesh.positions;
+    auto const& raw_indices = mesh.position_indices;
+
     auto [min_p, max_p] = elementwise_minmax(raw_vertices);
 
-    auto normals = calculate_mean_normals(raw_vertices, raw_indices);
+    // authored normals are used as is, if the file provides one for every corner;
+    // otherwise all normals are generated from the polygons
+    bool const has_authored_normals = is_fully_indexed(mesh.normal_indices);
+    auto normals = std::vector<glm::vec3>{};
+    if (!has_authored_normals) {
+        auto const normals_start = std::chrono::steady_clock::now();
+        normals = calculate_vertex_normals(raw_vertices, raw_indices, options.normal_weighting);
+        std::chrono::duration<double> const normals_time = std::chrono::steady_clock::now() - normals_start;
 
-    // make sure that the model touches zx-plane, that prevents the model from "flying"
-    // we leave z and x unchanged, so if model is not centered, it will remain not centered
-    auto offset = glm::vec3(0.0F, min_p.y, 0.0F);
-    auto scale = 1 / max_p.y - offset.y;
+        spdlog::info("generated normals of `{}` in {:.1f} ms, {:.1f} Mtri/s",
+          file_path, normals_time.count() * 1000.0,
+          static_cast<double>(raw_indices.size()) / 1e6 / normals_time.count());
+    }
+
+    auto const [offset, scale] = place_model(min_p, max_p);
 
-    auto res = std::vector<Vertex>{};
-    res.reserve(raw_indices.size() * 3);
-    for (auto const& idx : raw_indices) {
+    auto soup = std::vector<Vertex>{};
+    soup.reserve(raw_indices.size() * 3);
+    for (size_t polygon = 0; polygon < raw_indices.size(); ++polygon) {
+        auto const& idx = raw_indices[polygon];
         for (glm::length_t i{}; i < idx.length(); ++i) {
             auto v = raw_vertices[static_cast<size_t>(idx[i])];
             v -= offset;
-            res.emplace_back(v * scale, normals[idx[i]]);
+
+            auto const normal = has_authored_normals
+              ? glm::normalize(mesh.normals[mesh.normal_indices[polygon][i]])
+              : normals[idx[i]];
+
+            auto uv = glm::vec2{0.0F};
+            if (!mesh.uv_indices.empty() && mesh.uv_indices[polygon][i] != wavefront_no_index) {
+                uv = mesh.uvs[mesh.uv_indices[polygon][i]];
+            }
+
+            soup.emplace_back(v * scale, normal, uv);
         }
     }
 
-    return res;
-}
+    auto [vertices, indices] = weld_vertices(soup);
 
-/*******************************************************************************
- * parses a wavefront file and returns vertices and vectors of three elements
- * each representing a polygon of a model
- ******************************************************************************/
-std::pair<std::vector<glm::vec3>, std::vector<glm::uvec3>> parse_wavefront_file(std::string const& file_path)
-{
-    auto res = std::make_pair(std::vector<glm::vec3>{}, std::vector<glm::uvec3>{});
-    auto& [raw_vertices, raw_indices] = res;
+    if (options.optimize) {
+        auto const before = analyze_vertex_cache(indices, vertices.size());
+        optimize_vertex_cache(indices, vertices.size());
+        optimize_vertex_fetch(vertices, indices);
+        auto const after = analyze_vertex_cache(indices, vertices.size());
 
-    std::ifstream content_file(file_path);
-    if (!content_file) {
-        throw std::runtime_error("could not open the file");
+        spdlog::info("optimized `{}`: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+          file_path, before.acmr, after.acmr, before.atvr, after.atvr);
     }
 
-    char head{};
-    while (content_file >> head) {
-        switch (head) {
-        case '#':
-            content_file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            break;
-        case 'v':
-            float x, y, z; // NOLINT(cppcoreguidelines-init-variables)
-            content_file >> x >> y >> z;
-            raw_vertices.emplace_back(x, y, z);
-            content_file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-            break;
-        case 'f':
-            int a, b, c; // NOLINT(cppcoreguidelines-init-variables)
-            content_file >> a >> b >> c;
-            raw_indices.emplace_back(a - 1, b - 1, c - 1);
-            content_file.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    auto res = VertexModel{};
+    res.vertices = std::move(vertices);
+    res.lods.push_back({0, indices.size(), 0.0F});
+    res.indices = indices;
+
+    // every level is simplified from the previous one, so errors add up
+    auto level_indices = std::move(indices);
+    float level_error = 0.0F;
+    for (size_t level = 1; level < options.lod_count; ++level) {
+        auto simplified = simplify_mesh(res.vertices, level_indices, level_indices.size() / 2);
+
+        // a level which is barely smaller than the previous one is not worth it
+        if (simplified.indices.size() * 10 > level_indices.size() * 9) {
             break;
-        default:
-            throw std::runtime_error("unexpected entry");
         }
 
-        if (!content_file.good()) {
-            throw std::runtime_error("could not parse data");
+        if (options.optimize) {
+            optimize_vertex_cache(simplified.indices, res.vertices.size());
         }
+
+        level_error += simplified.error;
+        res.lods.push_back({res.indices.size(), simplified.indices.size(), level_error});
+        res.indices.insert(res.indices.end(), simplified.indices.cbegin(), simplified.indices.cend());
+        level_indices = std::move(simplified.indices);
+
+        spdlog::info("built level of detail {} of `{}`: {} triangles, error {:.2e}",
+          level, file_path, level_indices.size() / 3, level_error);
     }
 
-    content_file.close();
+    res.min_bound = glm::min((min_p - offset) * scale, (max_p - offset) * scale);
+    res.max_bound = glm::max((min_p - offset) * scale, (max_p - offset) * scale);
+
+    return res;
+}
+
+ModelPlacement place_model(glm::vec3 min_bound, glm::vec3 max_bound)
+{
+    // make sure that the model touches zx-plane, that prevents the model from "flying"
+    // we leave z and x unchanged, so if model is not centered, it will remain not centered
+    auto offset = glm::vec3(0.0F, min_bound.y, 0.0F);
+    auto scale = 1 / max_bound.y - offset.y;
+    return {offset, scale};
+}
+
+IndexedVertices weld_vertices(std::vector<Vertex> const& vertices)
+{
+    // vertices are compared bitwise, so the hash works on the raw bytes as well
+    struct VertexHash {
+        size_t operator()(Vertex const* v) const
+        {
+            return playground::hash_bytes(std::as_bytes(std::span{v, 1}));
+        }
+    };
+
+    struct VertexEqual {
+        bool operator()(Vertex const* a, Vertex const* b) const
+        {
+            return std::memcmp(a, b, sizeof(Vertex)) == 0;
+        }
+    };
+
+    IndexedVertices res{};
+    res.indices.reserve(vertices.size());
+
+    std::unordered_map<Vertex const*, uint32_t, VertexHash, VertexEqual> unique_vertices{};
+    unique_vertices.reserve(vertices.size());
+
+    for (auto const& v : vertices) {
+        auto const next_index = static_cast<uint32_t>(res.vertices.size());
+        auto [it, inserted] = unique_vertices.try_emplace(&v, next_index);
+        if (inserted) {
+            res.vertices.push_back(v);
+        }
+        res.indices.push_back(it->second);
+    }
 
     return res;
 }
 
+/*******************************************************************************
+ * checks that the attribute is referenced by every corner of every polygon
+ ******************************************************************************/
+bool is_fully_indexed(std::vector<glm::uvec3> const& indices)
+{
+    return !indices.empty() && std::all_of(indices.cbegin(), indices.cend(), [](glm::uvec3 const& polygon) {
+        return polygon.x != wavefront_no_index && polygon.y != wavefront_no_index && polygon.z != wavefront_no_index;
+    });
+}
+
 /*******************************************************************************
  * Calculates elementwise min and max of a iterator of vectors.
  * Example: given {-1, 1, 0} and {0, -1, 1} returns {-1, -1, 0} and {0, 1, 1}
@@ -111,32 +332,3 @@ std::pair<glm::vec3, glm::vec3> elementwise_minmax(std::vector<glm::vec3> const&
 
     return std::make_pair(min_v, max_v);
 }
-
-/*******************************************************************************
- * for each vertex the function takes all adjacent polygons,
- * calculates their normal vectors and assigns mean of these normal
- * to the given vertex
- ******************************************************************************/
-std::vector<glm::vec3> calculate_mean_normals(
-  std::vector<glm::vec3> const& vertices,
-  std::vector<glm::uvec3> const& indices)
-{
-    std::vector<glm::vec3> res(vertices.size()); // rolling mean, {0,0,0} initially
-    std::vector<size_t> counts(vertices.size()); // we need counts for the rolling mean
-
-    for (auto const& polygon_indices : indices) {
-        auto const& a = vertices[polygon_indices[0]];
-        auto const& b = vertices[polygon_indices[1]];
-        auto const& c = vertices[polygon_indices[2]];
-        auto norm = glm::normalize(glm::cross(b - a, c - a));
-
-        for (glm::length_t i{}; i < polygon_indices.length(); ++i) {
-            auto idx = polygon_indices[i];
-            auto n = static_cast<float>(++counts[idx]);
-            auto mean_norm = res[idx];
-            res[idx] = glm::normalize(mean_norm + (1.0F / n) * (norm - mean_norm));
-        }
-    }
-
-    return res;
-}
\ No newline at end of file
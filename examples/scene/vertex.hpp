@@ -1,12 +1,23 @@
 #ifndef PLAYGROUND_VERTEX_CPP_HPP
 #define PLAYGROUND_VERTEX_CPP_HPP
 
+#include <cstdint>
+#include <future>
 #include <string>
 #include <vector>
 #include <memory>
 
 #include <glm/glm.hpp>
 
+#include "../../playground/resource_manager.hpp"
+#include "../../playground/thread_pool.hpp"
+#include "mesh_codec.hpp"
+#include "normals.hpp"
+#include "wavefront.hpp"
+
+// defined in mesh_cache.hpp, which depends on this header
+struct MappedVertexModel;
+
 struct Vertex {
     glm::vec3 position{0.0F};
     glm::vec3 normal{0.0F};
@@ -19,26 +30,154 @@ struct Vertex {
       position{position}, normal{normal}, uv{uv} {}
 };
 
-using VertexModel = std::vector<Vertex>;
+/*******************************************************************************
+ * unique vertices and indices into them, every three indices form a polygon
+ ******************************************************************************/
+struct IndexedVertices {
+    std::vector<Vertex> vertices{};
+    std::vector<uint32_t> indices{};
+};
+
+/*******************************************************************************
+ * a level of detail is a range of indices into the vertices of its model,
+ * the error is the largest deviation from the full resolution surface
+ * in model units
+ ******************************************************************************/
+struct MeshLod {
+    size_t index_offset{};
+    size_t index_count{};
+    float error{};
+};
+
+/*******************************************************************************
+ * final model data ready to be uploaded to a VBO and an IBO,
+ * bounds are the elementwise min and max of the positions.
+ * `indices` holds all levels of detail one after another, from the full
+ * resolution one to the coarsest, all of them share the same vertices
+ ******************************************************************************/
+struct VertexModel {
+    std::vector<Vertex> vertices{};
+    std::vector<uint32_t> indices{};
+    std::vector<MeshLod> lods{};
+    glm::vec3 min_bound{0.0F};
+    glm::vec3 max_bound{0.0F};
+};
+
+/*******************************************************************************
+ * turns a triangle soup (every three vertices form a polygon) into
+ * an indexed mesh, vertices with bitwise identical position, normal and uv
+ * are merged into one. The order of the vertices is the order of their
+ * first appearance in the soup
+ ******************************************************************************/
+IndexedVertices weld_vertices(std::vector<Vertex> const& vertices);
+
+struct LoadOptions {
+    WavefrontParser parser{WavefrontParser::Parallel};
+
+    // used only when the file does not provide a normal for every corner
+    NormalWeighting normal_weighting{NormalWeighting::Angle};
+
+    // reorder triangles and vertices for the post-transform cache and the vertex fetch
+    bool optimize{true};
+
+    // number of levels of detail including the full resolution one,
+    // every next level has about half of the triangles of the previous one
+    size_t lod_count{5};
+
+    // keep a baked copy of the model next to the source file and use it
+    // instead of parsing as long as the source file does not change
+    bool use_cache{true};
+
+    // the baked copy is compressed, so it is smaller and faster to read from a cold disk
+    MeshCompression cache_compression{MeshCompression::Deflate};
+
+    // files larger than this many bytes are converted out of core into the
+    // cache, regardless of `use_cache`, and can only be mapped with
+    // `map_vertex_model`, 0 means no limit.
+    // Such models are neither welded, optimized nor simplified
+    size_t memory_limit{0};
+};
+
+/*******************************************************************************
+ * transform which puts a model with the given bounds on the zx-plane
+ * and scales it, applied as `(position - offset) * scale`
+ ******************************************************************************/
+struct ModelPlacement {
+    glm::vec3 offset{0.0F};
+    float scale{1.0F};
+};
+
+ModelPlacement place_model(glm::vec3 min_bound, glm::vec3 max_bound);
 
 /*******************************************************************************
  * parses and wavefront file and returns a 3D model,
- * i.e. vertices grouped by 3 to represent a polygon and normal vector
- * for each vertex. The normal vectors are automatically generated based
- * on normal vectors of adjacent polygons for each vertex
+ * i.e. unique vertices and indices grouped by 3 to represent a polygon
+ * and normal vector for each vertex. Uvs of the file are used where polygons
+ * reference them, normal vectors of the file are used when every polygon
+ * references them, otherwise the normal vectors are automatically generated
+ * based on normal vectors of adjacent polygons for each vertex
+ ******************************************************************************/
+VertexModel read_vertex_model(std::string const& file_path, LoadOptions const& options = {});
+
+/*******************************************************************************
+ * true for files over `LoadOptions::memory_limit`,
+ * which `read_vertex_model` refuses and `map_vertex_model` maps
+ ******************************************************************************/
+bool exceeds_memory_limit(std::string const& file_path, LoadOptions const& options);
+
+/*******************************************************************************
+ * bakes the model into an uncompressed cache of its own, unless it is baked
+ * already, and maps it, the only way to load files over `LoadOptions::memory_limit`.
+ * The cache is keyed by the size and the modification time of the file.
+ * The vertices and indices are laid out as in a VBO and an IBO, so they are
+ * uploaded in ranges straight from the mapping, e.g. by `MappedShape`,
+ * without the model ever being in the process memory as a whole
+ ******************************************************************************/
+MappedVertexModel map_vertex_model(std::string const& file_path, LoadOptions const& options = {});
+
+/*******************************************************************************
+ * reads a model once per file and options, later calls share the same model
+ * as long as it is held somewhere or cached by the resource manager
  ******************************************************************************/
-VertexModel read_vertex_model(std::string const& file_path);
+std::shared_ptr<VertexModel const> read_shared_vertex_model(
+  playground::ResourceManager& resources, std::string const& file_path, LoadOptions const& options = {});
 
 /*******************************************************************************
  * loads a model and instantiates and object feeding it with this model
  ******************************************************************************/
 template<class T>
-T load_model(std::string const& file_path)
+T load_model(std::string const& file_path, LoadOptions const& options = {})
 {
-    auto model = read_vertex_model(file_path);
+    auto model = read_vertex_model(file_path, options);
     auto res = T{std::make_shared<VertexModel const>(std::move(model))};
     return res;
 }
 
+/*******************************************************************************
+ * loads a model on a thread of the pool, the caller polls the future and
+ * uploads the object's data on the GL thread once it is ready.
+ * Errors of the loading are rethrown by the future's `get`
+ ******************************************************************************/
+template<class T>
+std::future<T> load_model_async(playground::ThreadPool& pool, std::string file_path, LoadOptions options = {})
+{
+    return pool.submit([file_path = std::move(file_path), options]() {
+        return load_model<T>(file_path, options);
+    });
+}
+
+/*******************************************************************************
+ * same as above, but the model is shared through the resource manager,
+ * which must outlive the pool's tasks
+ ******************************************************************************/
+template<class T>
+std::future<T> load_model_async(
+  playground::ThreadPool& pool, playground::ResourceManager& resources, std::string file_path, LoadOptions options = {})
+{
+    return pool.submit([&resources, file_path = std::move(file_path), options]() {
+        return T{read_shared_vertex_model(resources, file_path, options)};
+    });
+}
+
 
 #endif // PLAYGROUND_VERTEX_CPP_HPP
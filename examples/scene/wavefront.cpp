@@ -0,0 +1,553 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+#include "../../playground/mapped_file.hpp"
+#include "wavefront.hpp"
+
+static WavefrontMesh parse_wavefront_stream(std::string const& file_path);
+
+WavefrontMesh parse_wavefront_file(std::string const& file_path, WavefrontParser parser)
+{
+    switch (parser) {
+    case WavefrontParser::Stream:
+        return parse_wavefront_stream(file_path);
+    case WavefrontParser::Mapped: {
+        playground::MappedFile const file{file_path};
+        return parse_wavefront_buffer(file.view());
+    }
+    case WavefrontParser::Parallel: {
+        playground::MappedFile const file{file_path};
+        return parse_wavefront_buffer(file.view(), std::max(1U, std::thread::hardware_concurrency()));
+    }
+    }
+
+    throw std::runtime_error("unexpected parser");
+}
+
+static bool is_blank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static char const* skip_blanks(char const* it, char const* end)
+{
+    while (it != end && is_blank(*it)) {
+        ++it;
+    }
+    return it;
+}
+
+static char const* skip_line(char const* it, char const* end)
+{
+    while (it != end && *it != '\n') {
+        ++it;
+    }
+    return it;
+}
+
+static char const* skip_token(char const* it, char const* end)
+{
+    while (it != end && !is_blank(*it) && *it != '\n') {
+        ++it;
+    }
+    return it;
+}
+
+/*******************************************************************************
+ * parses a single blank-separated number starting at `it`,
+ * `std::from_chars` ignores the locale and does not accept a leading plus,
+ * which `operator>>` does, so the plus is skipped manually
+ ******************************************************************************/
+template <class T>
+static char const* parse_number(char const* it, char const* end, T& value, char separator = ' ')
+{
+    it = skip_blanks(it, end);
+    if (it != end && *it == '+') {
+        ++it;
+    }
+
+    auto [ptr, ec] = std::from_chars(it, end, value);
+    if (ec != std::errc{} || (ptr != end && !is_blank(*ptr) && *ptr != '\n' && *ptr != separator)) {
+        throw std::runtime_error("could not parse data");
+    }
+    return ptr;
+}
+
+/*******************************************************************************
+ * Parses whole lines of a wavefront file and accumulates the result,
+ * so a file can be fed to it block by block.
+ * Negative indices are resolved against the number of attributes this reader
+ * has seen so far. When a file is split between several readers, the
+ * attributes of the preceding chunks are unknown; such indices are recorded
+ * in `relative_corners` (as positions of the corners in the flattened index
+ * arrays), they have to be shifted by the number of attributes in the
+ * preceding chunks
+ ******************************************************************************/
+class WavefrontReader {
+public:
+    enum Attribute {
+        Position,
+        Uv,
+        Normal,
+        AttributeCount
+    };
+
+    // relative indices of the first chunk cannot point before it
+    explicit WavefrontReader(bool is_first_chunk = true) :
+      is_first_chunk_{is_first_chunk} {}
+
+    void parse(std::string_view content);
+
+    [[nodiscard]] WavefrontMesh& mesh() { return mesh_; }
+
+    [[nodiscard]] std::vector<size_t> const& relative_corners(Attribute attribute) const { return relative_corners_[attribute]; }
+
+private:
+    struct Corner {
+        std::array<uint32_t, AttributeCount> index{wavefront_no_index, wavefront_no_index, wavefront_no_index};
+        std::array<bool, AttributeCount> relative{};
+    };
+
+    bool is_first_chunk_{};
+    WavefrontMesh mesh_{};
+    std::array<std::vector<size_t>, AttributeCount> relative_corners_{};
+
+    // reused between faces to avoid an allocation per line
+    std::vector<Corner> corners_{};
+
+    char const* parse_face(char const* it, char const* end);
+    char const* parse_corner_index(char const* it, char const* end, Corner& corner, Attribute attribute);
+    void add_triangle(Corner const& a, Corner const& b, Corner const& c);
+
+    [[nodiscard]] size_t attribute_count(Attribute attribute) const;
+    [[nodiscard]] std::vector<glm::uvec3>& attribute_indices(Attribute attribute);
+};
+
+void WavefrontReader::parse(std::string_view content)
+{
+    using namespace std::string_view_literals;
+
+    char const* it = content.data();
+    char const* const end = content.data() + content.size();
+
+    while (it != end) {
+        it = skip_blanks(it, end);
+        if (it == end) {
+            break;
+        }
+        if (*it == '\n') {
+            ++it;
+            continue;
+        }
+
+        char const* const keyword_end = skip_token(it, end);
+        std::string_view const keyword{it, static_cast<size_t>(keyword_end - it)};
+        it = keyword_end;
+
+        if (keyword.starts_with('#')) {
+            // comment, the rest of the line is skipped below
+        } else if (keyword == "v"sv) {
+            float x, y, z; // NOLINT(cppcoreguidelines-init-variables)
+            it = parse_number(it, end, x);
+            it = parse_number(it, end, y);
+            it = parse_number(it, end, z);
+            // an optional w or vertex colors may follow, they are ignored
+            mesh_.positions.emplace_back(x, y, z);
+        } else if (keyword == "vt"sv) {
+            float u{}, v{};
+            it = parse_number(it, end, u);
+            // v is optional in the format and defaults to 0
+            it = skip_blanks(it, end);
+            if (it != end && *it != '\n') {
+                it = parse_number(it, end, v);
+            }
+            mesh_.uvs.emplace_back(u, v);
+        } else if (keyword == "vn"sv) {
+            float x, y, z; // NOLINT(cppcoreguidelines-init-variables)
+            it = parse_number(it, end, x);
+            it = parse_number(it, end, y);
+            it = parse_number(it, end, z);
+            mesh_.normals.emplace_back(x, y, z);
+        } else if (keyword == "f"sv) {
+            it = parse_face(it, end);
+        } else if (keyword == "o"sv || keyword == "g"sv || keyword == "s"sv || keyword == "usemtl"sv || keyword == "mtllib"sv) {
+            // grouping and materials do not affect the geometry
+        } else {
+            throw std::runtime_error("unexpected entry");
+        }
+
+        it = skip_line(it, end);
+    }
+}
+
+char const* WavefrontReader::parse_face(char const* it, char const* end)
+{
+    corners_.clear();
+
+    while (true) {
+        it = skip_blanks(it, end);
+        // a trailing comment ends the polygon as well
+        if (it == end || *it == '\n' || *it == '#') {
+            break;
+        }
+
+        Corner corner{};
+        it = parse_corner_index(it, end, corner, Position);
+        if (it != end && *it == '/') {
+            ++it;
+            if (it != end && *it != '/') {
+                it = parse_corner_index(it, end, corner, Uv);
+            }
+            if (it != end && *it == '/') {
+                ++it;
+                it = parse_corner_index(it, end, corner, Normal);
+            }
+        }
+        corners_.push_back(corner);
+    }
+
+    if (corners_.size() < 3) {
+        throw std::runtime_error("could not parse data");
+    }
+
+    for (size_t i = 1; i + 1 < corners_.size(); ++i) {
+        add_triangle(corners_[0], corners_[i], corners_[i + 1]);
+    }
+
+    return it;
+}
+
+char const* WavefrontReader::parse_corner_index(char const* it, char const* end, Corner& corner, Attribute attribute)
+{
+    int64_t raw_index{};
+    it = parse_number(it, end, raw_index, '/');
+
+    auto const count = static_cast<int64_t>(attribute_count(attribute));
+    int64_t const resolved = raw_index > 0 ? raw_index - 1 : count + raw_index;
+    if (raw_index == 0 || resolved >= std::numeric_limits<uint32_t>::max() || (is_first_chunk_ && resolved < 0)) {
+        throw std::runtime_error("could not parse data");
+    }
+
+    // a relative index may point into a preceding chunk and be negative for now,
+    // unsigned arithmetic wraps around and gives the right value once shifted
+    corner.index[attribute] = static_cast<uint32_t>(resolved);
+    corner.relative[attribute] = raw_index < 0;
+
+    return it;
+}
+
+void WavefrontReader::add_triangle(Corner const& a, Corner const& b, Corner const& c)
+{
+    std::array<Corner const*, 3> const triangle{&a, &b, &c};
+    size_t const triangle_index = mesh_.position_indices.size();
+
+    for (auto attribute : {Position, Uv, Normal}) {
+        auto& indices = attribute_indices(attribute);
+
+        bool const referenced = std::any_of(triangle.cbegin(), triangle.cend(), [attribute](auto const* corner) {
+            return corner->index[attribute] != wavefront_no_index || corner->relative[attribute];
+        });
+
+        // uv and normal indices are only materialized once the first polygon references them
+        if (attribute != Position && indices.empty() && !referenced) {
+            continue;
+        }
+        indices.resize(triangle_index, glm::uvec3{wavefront_no_index});
+
+        glm::uvec3 value{};
+        for (glm::length_t i{}; i < value.length(); ++i) {
+            auto const& corner = *triangle[static_cast<size_t>(i)];
+            value[i] = corner.index[attribute];
+            if (corner.relative[attribute]) {
+                relative_corners_[attribute].push_back(triangle_index * 3 + static_cast<size_t>(i));
+            }
+        }
+        indices.push_back(value);
+    }
+}
+
+size_t WavefrontReader::attribute_count(Attribute attribute) const
+{
+    switch (attribute) {
+    case Position:
+        return mesh_.positions.size();
+    case Uv:
+        return mesh_.uvs.size();
+    case Normal:
+        return mesh_.normals.size();
+    case AttributeCount:
+        break;
+    }
+    throw std::runtime_error("unexpected attribute");
+}
+
+std::vector<glm::uvec3>& WavefrontReader::attribute_indices(Attribute attribute)
+{
+    switch (attribute) {
+    case Position:
+        return mesh_.position_indices;
+    case Uv:
+        return mesh_.uv_indices;
+    case Normal:
+        return mesh_.normal_indices;
+    case AttributeCount:
+        break;
+    }
+    throw std::runtime_error("unexpected attribute");
+}
+
+/*******************************************************************************
+ * makes sure that every index points to an existing attribute,
+ * that can only be done once the whole file is parsed
+ ******************************************************************************/
+static void validate_indices(WavefrontMesh const& mesh)
+{
+    auto validate = [](std::vector<glm::uvec3> const& indices, size_t count, bool optional) {
+        for (auto const& polygon : indices) {
+            for (glm::length_t i{}; i < polygon.length(); ++i) {
+                if (polygon[i] >= count && !(optional && polygon[i] == wavefront_no_index)) {
+                    throw std::runtime_error("index out of range");
+                }
+            }
+        }
+    };
+
+    validate(mesh.position_indices, mesh.positions.size(), false);
+    validate(mesh.uv_indices, mesh.uvs.size(), true);
+    validate(mesh.normal_indices, mesh.normals.size(), true);
+}
+
+/*******************************************************************************
+ * reads the file in fixed-size blocks and feeds whole lines to the reader,
+ * an incomplete last line is carried over to the next block
+ ******************************************************************************/
+WavefrontMesh parse_wavefront_stream(std::string const& file_path)
+{
+    static size_t const block_size = 1024UL * 1024UL;
+
+    std::ifstream content_file(file_path, std::ios::binary);
+    if (!content_file) {
+        throw std::runtime_error("could not open the file");
+    }
+
+    WavefrontReader reader{};
+    std::string buffer{};
+    size_t carried = 0;
+
+    while (true) {
+        // only grows beyond one block when a single line is longer than a block
+        buffer.resize(carried + block_size);
+        content_file.read(buffer.data() + carried, static_cast<std::streamsize>(block_size));
+        size_t const filled = carried + static_cast<size_t>(content_file.gcount());
+        std::string_view const block{buffer.data(), filled};
+
+        if (!content_file) {
+            if (content_file.bad()) {
+                throw std::runtime_error("could not read the file");
+            }
+            reader.parse(block);
+            break;
+        }
+
+        auto const last_newline = block.rfind('\n');
+        if (last_newline == std::string_view::npos) {
+            carried = filled;
+            continue;
+        }
+
+        reader.parse(block.substr(0, last_newline + 1));
+        carried = filled - (last_newline + 1);
+        std::memmove(buffer.data(), buffer.data() + last_newline + 1, carried);
+    }
+
+    auto res = std::move(reader.mesh());
+    validate_indices(res);
+    return res;
+}
+
+/*******************************************************************************
+ * parses the content in place: no copies of the lines are made and
+ * numbers are converted straight from the characters
+ ******************************************************************************/
+WavefrontMesh parse_wavefront_buffer(std::string_view content)
+{
+    WavefrontReader reader{};
+    reader.parse(content);
+
+    auto res = std::move(reader.mesh());
+    validate_indices(res);
+    return res;
+}
+
+/*******************************************************************************
+ * splits the content into at most `chunk_count` pieces, each piece starts
+ * at the beginning of a line and ends right after a newline (or at the end
+ * of the content), so every piece can be parsed on its own
+ ******************************************************************************/
+static std::vector<std::string_view> split_into_lines_chunks(std::string_view content, size_t chunk_count)
+{
+    std::vector<std::string_view> res{};
+    res.reserve(chunk_count);
+
+    size_t begin = 0;
+    for (size_t i = 1; i <= chunk_count && begin < content.size(); ++i) {
+        size_t end = content.size() * i / chunk_count;
+        if (end < begin) {
+            end = begin;
+        }
+        end = content.find('\n', end);
+        end = end == std::string_view::npos ? content.size() : end + 1;
+        res.push_back(content.substr(begin, end - begin));
+        begin = end;
+    }
+
+    return res;
+}
+
+/*******************************************************************************
+ * shifts relative indices of a chunk, which starts at `first_polygon` of
+ * `indices`, by the number of attributes in the preceding chunks
+ ******************************************************************************/
+static void rebase_relative_indices(
+  std::vector<glm::uvec3>& indices, size_t first_polygon, std::vector<size_t> const& corners, size_t shift)
+{
+    for (auto corner : corners) {
+        auto& index = indices[first_polygon + corner / 3][static_cast<glm::length_t>(corner % 3)];
+        // the index is negative while it points into a preceding chunk
+        if (static_cast<int32_t>(index) + static_cast<int64_t>(shift) < 0) {
+            throw std::runtime_error("index out of range");
+        }
+        index += static_cast<uint32_t>(shift);
+    }
+}
+
+template <class T>
+static void copy_chunk(std::vector<T> const& source, std::vector<T>& destination, size_t offset)
+{
+    std::copy(source.cbegin(), source.cend(), destination.begin() + static_cast<std::ptrdiff_t>(offset));
+}
+
+WavefrontMesh parse_wavefront_buffer(std::string_view content, size_t thread_count)
+{
+    // below this size spawning threads costs more than parsing itself
+    static size_t const min_chunk_size = 1024UL * 1024UL;
+
+    size_t const chunk_count = std::clamp(content.size() / min_chunk_size, 1UL, std::max(thread_count, 1UL));
+    if (chunk_count == 1) {
+        return parse_wavefront_buffer(content);
+    }
+
+    auto chunks = split_into_lines_chunks(content, chunk_count);
+
+    std::vector<WavefrontReader> readers{};
+    readers.reserve(chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        readers.emplace_back(i == 0);
+    }
+    std::vector<std::future<void>> parsed_futures{};
+    parsed_futures.reserve(chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        parsed_futures.push_back(std::async(std::launch::async, [&reader = readers[i], chunk = chunks[i]]() {
+            reader.parse(chunk);
+        }));
+    }
+    for (auto& f : parsed_futures) {
+        f.get();
+    }
+
+    // exclusive prefix sums give the position of every chunk in the output and
+    // the number of attributes preceding it, which rebases relative indices
+    struct Offsets {
+        size_t positions{};
+        size_t uvs{};
+        size_t normals{};
+        size_t polygons{};
+    };
+
+    std::vector<Offsets> offsets(readers.size() + 1);
+    bool has_uv_indices = false;
+    bool has_normal_indices = false;
+    for (size_t i = 0; i < readers.size(); ++i) {
+        auto const& mesh = readers[i].mesh();
+        offsets[i + 1] = {
+          offsets[i].positions + mesh.positions.size(),
+          offsets[i].uvs + mesh.uvs.size(),
+          offsets[i].normals + mesh.normals.size(),
+          offsets[i].polygons + mesh.position_indices.size()};
+        has_uv_indices = has_uv_indices || !mesh.uv_indices.empty();
+        has_normal_indices = has_normal_indices || !mesh.normal_indices.empty();
+    }
+
+    // chunks that never referenced uvs or normals leave `wavefront_no_index` behind,
+    // just like the serial reader back-fills polygons parsed before the first reference
+    auto const& total = offsets.back();
+    WavefrontMesh res{
+      std::vector<glm::vec3>(total.positions),
+      std::vector<glm::vec2>(total.uvs),
+      std::vector<glm::vec3>(total.normals),
+      std::vector<glm::uvec3>(total.polygons),
+      std::vector<glm::uvec3>(has_uv_indices ? total.polygons : 0, glm::uvec3{wavefront_no_index}),
+      std::vector<glm::uvec3>(has_normal_indices ? total.polygons : 0, glm::uvec3{wavefront_no_index})};
+
+    std::vector<std::future<void>> copy_futures{};
+    copy_futures.reserve(readers.size());
+    for (size_t i = 0; i < readers.size(); ++i) {
+        copy_futures.push_back(std::async(std::launch::async, [&, i]() {
+            auto const& reader = readers[i];
+            auto const& mesh = readers[i].mesh();
+            auto const& offset = offsets[i];
+
+            copy_chunk(mesh.positions, res.positions, offset.positions);
+            copy_chunk(mesh.uvs, res.uvs, offset.uvs);
+            copy_chunk(mesh.normals, res.normals, offset.normals);
+            copy_chunk(mesh.position_indices, res.position_indices, offset.polygons);
+            copy_chunk(mesh.uv_indices, res.uv_indices, offset.polygons);
+            copy_chunk(mesh.normal_indices, res.normal_indices, offset.polygons);
+
+            rebase_relative_indices(res.position_indices, offset.polygons, reader.relative_corners(WavefrontReader::Position), offset.positions);
+            rebase_relative_indices(res.uv_indices, offset.polygons, reader.relative_corners(WavefrontReader::Uv), offset.uvs);
+            rebase_relative_indices(res.normal_indices, offset.polygons, reader.relative_corners(WavefrontReader::Normal), offset.normals);
+        }));
+    }
+    for (auto& f : copy_futures) {
+        f.get();
+    }
+
+    validate_indices(res);
+    return res;
+}
+
+void parse_wavefront_blocks(
+  std::string_view content, size_t block_size, std::function<void(WavefrontMesh const&)> const& consume)
+{
+    size_t positions = 0;
+    size_t uvs = 0;
+    size_t normals = 0;
+
+    size_t begin = 0;
+    while (begin < content.size()) {
+        auto end = content.find('\n', std::min(begin + std::max(block_size, 1UL), content.size()) - 1);
+        end = end == std::string_view::npos ? content.size() : end + 1;
+
+        WavefrontReader reader{begin == 0};
+        reader.parse(content.substr(begin, end - begin));
+        begin = end;
+
+        auto& mesh = reader.mesh();
+        rebase_relative_indices(mesh.position_indices, 0, reader.relative_corners(WavefrontReader::Position), positions);
+        rebase_relative_indices(mesh.uv_indices, 0, reader.relative_corners(WavefrontReader::Uv), uvs);
+        rebase_relative_indices(mesh.normal_indices, 0, reader.relative_corners(WavefrontReader::Normal), normals);
+
+        positions += mesh.positions.size();
+        uvs += mesh.uvs.size();
+        normals += mesh.normals.size();
+
+        consume(mesh);
+    }
+}
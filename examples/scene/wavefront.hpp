@@ -0,0 +1,71 @@
+#ifndef PLAYGROUND_WAVEFRONT_HPP
+#define PLAYGROUND_WAVEFRONT_HPP
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// marks a polygon corner that does not reference a uv or a normal
+inline constexpr uint32_t wavefront_no_index = std::numeric_limits<uint32_t>::max();
+
+/*******************************************************************************
+ * attributes of a model as they are listed in the file and vectors of three
+ * elements each representing a polygon of the model, n-gons are split into
+ * triangles as a fan around their first corner.
+ * Indices are 0-based, negative (relative) indices of the file are resolved.
+ * `uv_indices` and `normal_indices` are either empty, when no polygon
+ * references uvs or normals, or as long as `position_indices`, in that case
+ * corners without the attribute hold `wavefront_no_index`
+ ******************************************************************************/
+struct WavefrontMesh {
+    std::vector<glm::vec3> positions{};
+    std::vector<glm::vec2> uvs{};
+    std::vector<glm::vec3> normals{};
+
+    std::vector<glm::uvec3> position_indices{};
+    std::vector<glm::uvec3> uv_indices{};
+    std::vector<glm::uvec3> normal_indices{};
+};
+
+enum class WavefrontParser {
+    Stream, // the file is read in fixed-size blocks, memory use does not depend on the file size
+    Mapped, // the file is memory-mapped and parsed in place
+    Parallel, // the mapped file is split into chunks parsed on all cores
+};
+
+/*******************************************************************************
+ * parses a wavefront file with the given parser,
+ * all parsers produce exactly the same output for the same file.
+ * Supported entries are `v`, `vt`, `vn` and `f` with `v`, `v/vt`, `v//vn`
+ * and `v/vt/vn` corners; `o`, `g`, `s`, `usemtl` and `mtllib` are skipped
+ ******************************************************************************/
+WavefrontMesh parse_wavefront_file(std::string const& file_path, WavefrontParser parser = WavefrontParser::Parallel);
+
+/*******************************************************************************
+ * parses wavefront content which is already in memory
+ ******************************************************************************/
+WavefrontMesh parse_wavefront_buffer(std::string_view content);
+
+/*******************************************************************************
+ * splits the content into newline-aligned chunks and parses them concurrently,
+ * the result is bit-identical to `parse_wavefront_buffer`
+ ******************************************************************************/
+WavefrontMesh parse_wavefront_buffer(std::string_view content, size_t thread_count);
+
+/*******************************************************************************
+ * parses the content in consecutive newline-aligned blocks of about
+ * `block_size` bytes and hands every block to `consume` before parsing
+ * the next one, so only one parsed block is in memory at a time.
+ * Attributes of a block follow the attributes of all preceding blocks,
+ * indices refer to the whole content. Indices are not checked against the
+ * number of attributes, that number is known only after the last block
+ ******************************************************************************/
+void parse_wavefront_blocks(
+  std::string_view content, size_t block_size, std::function<void(WavefrontMesh const&)> const& consume);
+
+#endif // PLAYGROUND_WAVEFRONT_HPP
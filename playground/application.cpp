@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <fmt/core.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <gsl/narrow>
@@ -77,12 +79,21 @@ Application::Application(int width, int height) :
     glGenBuffers(1, &vbo_);
     glGenBuffers(1, &ibo_);
     glGenVertexArrays(1, &vao_);
+
+    GLint storage_alignment{};
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storage_alignment);
+    storage_alignment_ = std::max(gsl::narrow<size_t>(storage_alignment), 1UL);
 }
 
 Application::~Application()
 {
     spdlog::info("shutting down");
 
+    // the buffers are freed while the context is alive
+    capture_.reset();
+    stream_vbo_.reset();
+    stream_storage_.reset();
+
     glDeleteBuffers(1, &vbo_);
     glDeleteVertexArrays(1, &vao_);
 
@@ -104,6 +115,12 @@ void Application::start()
     while (keep_running_) {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        for (auto* stream : {stream_vbo_.get(), stream_storage_.get()}) {
+            if (stream) {
+                stream->begin_frame();
+            }
+        }
+
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplSDL2_NewFrame();
         ImGui::NewFrame();
@@ -154,6 +171,16 @@ void Application::start()
 
         glBindVertexArray(0);
 
+        for (auto* stream : {stream_vbo_.get(), stream_storage_.get()}) {
+            if (stream) {
+                stream->end_frame();
+            }
+        }
+
+        if (capture_) {
+            capture_->capture(window_size_);
+        }
+
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
@@ -170,8 +197,29 @@ std::unique_ptr<Program> Application::create_program(std::string const& vertex_s
 
 void Application::use_program(Program const& p)
 {
-    current_program_id_ = p.get_id();
-    glUseProgram(current_program_id_);
+    current_program_ = &p;
+    glUseProgram(current_program_->get_id());
+}
+
+void Application::start_capture(CaptureOptions options)
+{
+    stop_capture();
+    spdlog::info("capturing frames to `{}`", options.directory);
+    capture_ = std::make_unique<FrameCapture>(std::move(options));
+}
+
+void Application::stop_capture()
+{
+    if (capture_) {
+        capture_->finish();
+        last_capture_stats_ = capture_->stats();
+        capture_.reset();
+    }
+}
+
+CaptureStats Application::capture_stats() const
+{
+    return capture_ ? capture_->stats() : last_capture_stats_;
 }
 
 void Application::alloc_vbo(size_t size)
@@ -200,27 +248,101 @@ void Application::upload_vbo(void const* data, size_t offset, size_t size)
 
 void Application::assign_vbo(std::string const& name, int components, size_t stride, size_t offset)
 {
-    auto attribute_location = glGetAttribLocation(current_program_id_, name.c_str());
-    assign_vbo(attribute_location, components, stride, offset);
+    assign_vbo(name, components, AttributeType::Float, false, stride, offset);
 }
 
 void Application::assign_vbo(GLint attribute_location, int components, size_t stride, size_t offset)
+{
+    assign_vbo(attribute_location, components, AttributeType::Float, false, stride, offset);
+}
+
+void Application::assign_vbo(
+  std::string const& name, int components, AttributeType type, bool normalized, size_t stride, size_t offset)
+{
+    auto attribute_location = current_program()->attribute_location(name);
+    assign_vbo(attribute_location, components, type, normalized, stride, offset);
+}
+
+void Application::assign_vbo(
+  GLint attribute_location, int components, AttributeType type, bool normalized, size_t stride, size_t offset)
 {
     created_attributes_.insert(attribute_location);
 
+    // attributes read binding point 0, so switching the buffer behind it keeps them as they are
     glBindVertexArray(vao_);
 
-    glVertexAttribPointer(
+    glVertexAttribFormat(
       attribute_location,
       components,
-      GL_FLOAT,
-      GL_FALSE,
-      gsl::narrow<GLsizei>(stride),
-      reinterpret_cast<GLvoid const*>(offset)); // NOLINT(performance-no-int-to-ptr)
+      static_cast<GLenum>(type),
+      normalized ? GL_TRUE : GL_FALSE,
+      gsl::narrow<GLuint>(offset));
+    glVertexAttribBinding(attribute_location, 0);
 
     glEnableVertexAttribArray(attribute_location);
 
     glBindVertexArray(0);
+
+    vertex_stride_ = stride;
+    glVertexArrayVertexBuffer(vao_, 0, stream_vbo_used_ ? stream_vbo_->id() : vbo_, 0, gsl::narrow<GLsizei>(vertex_stride_));
+}
+
+void Application::alloc_stream_vbo(size_t frame_size)
+{
+    // the old buffer is deleted once the GPU is done with it
+    use_vbo();
+    stream_vbo_ = std::make_unique<StreamBuffer>(GL_ARRAY_BUFFER, frame_size);
+}
+
+StreamAllocation Application::map_stream_vbo(size_t size, size_t alignment)
+{
+    if (!stream_vbo_) {
+        throw std::runtime_error("The stream VBO is not allocated");
+    }
+    return stream_vbo_->allocate(size, alignment);
+}
+
+void Application::use_vbo()
+{
+    if (stream_vbo_used_) {
+        stream_vbo_used_ = false;
+        glVertexArrayVertexBuffer(vao_, 0, vbo_, 0, gsl::narrow<GLsizei>(vertex_stride_));
+    }
+}
+
+void Application::use_stream_vbo()
+{
+    if (!stream_vbo_used_ && stream_vbo_) {
+        stream_vbo_used_ = true;
+        glVertexArrayVertexBuffer(vao_, 0, stream_vbo_->id(), 0, gsl::narrow<GLsizei>(vertex_stride_));
+    }
+}
+
+StreamBufferStats Application::stream_vbo_stats() const
+{
+    return stream_vbo_ ? stream_vbo_->stats() : StreamBufferStats{};
+}
+
+void Application::alloc_stream_storage(size_t frame_size)
+{
+    // bound ranges of the old buffer keep it alive until the GPU is done with it
+    stream_storage_ = std::make_unique<StreamBuffer>(GL_SHADER_STORAGE_BUFFER, frame_size);
+}
+
+StreamAllocation Application::map_stream_storage(GLuint binding, size_t size)
+{
+    if (!stream_storage_) {
+        throw std::runtime_error("The stream storage buffer is not allocated");
+    }
+    auto const allocation = stream_storage_->allocate(size, storage_alignment_);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, stream_storage_->id(),
+      gsl::narrow<GLintptr>(allocation.offset), gsl::narrow<GLsizeiptr>(size));
+    return allocation;
+}
+
+StreamBufferStats Application::stream_storage_stats() const
+{
+    return stream_storage_ ? stream_storage_->stats() : StreamBufferStats{};
 }
 
 void Application::alloc_ibo(size_t size)
@@ -277,17 +399,79 @@ void Application::set_uniform_data(std::string const& name, glm::vec3 const& dat
     glUniform3fv(id, 1, glm::value_ptr(data));
 }
 
+void Application::set_uniform_data(std::string const& name, glm::vec4 const& data)
+{
+    auto id = get_uniform_location(name);
+    glUniform4fv(id, 1, glm::value_ptr(data));
+}
+
 void Application::draw_simple_vertices(size_t vertex_count, DrawType draw_type)
 {
     glDrawArrays(draw_type, 0, gsl::narrow<GLsizei>(vertex_count));
 }
 
-void Application::draw_indices(size_t vertex_count, DrawType draw_type, size_t offset_count)
+void Application::draw_indices(size_t index_count, DrawType draw_type, size_t offset_count, size_t base_vertex, IndexType index_type)
 {
+    size_t const index_size = index_type == UnsignedShort ? sizeof(GLushort) : sizeof(GLuint);
+
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
     // NOLINTNEXTLINE(performance-no-int-to-ptr): has to be a pointer for glDrawElements
-    auto const* offset_bytes_ptr = reinterpret_cast<void*>(offset_count * sizeof(GLuint));
-    glDrawElements(draw_type, gsl::narrow<GLsizei>(vertex_count), GL_UNSIGNED_INT, offset_bytes_ptr);
+    auto* offset_bytes_ptr = reinterpret_cast<void*>(offset_count * index_size);
+    glDrawElementsBaseVertex(
+      draw_type,
+      gsl::narrow<GLsizei>(index_count),
+      index_type,
+      offset_bytes_ptr,
+      gsl::narrow<GLint>(base_vertex));
+}
+
+void Application::draw_multi_indices(std::span<IndexRange const> ranges, DrawType draw_type, size_t base_vertex, IndexType index_type)
+{
+    size_t const index_size = index_type == UnsignedShort ? sizeof(GLushort) : sizeof(GLuint);
+
+    multi_draw_counts_.clear();
+    multi_draw_offsets_.clear();
+    multi_draw_base_vertices_.clear();
+    for (auto const& range : ranges) {
+        multi_draw_counts_.push_back(gsl::narrow<GLsizei>(range.index_count));
+        // NOLINTNEXTLINE(performance-no-int-to-ptr): has to be a pointer for glMultiDrawElements
+        multi_draw_offsets_.push_back(reinterpret_cast<void const*>(range.offset_count * index_size));
+        multi_draw_base_vertices_.push_back(gsl::narrow<GLint>(base_vertex));
+    }
+    draw_multi_ranges(draw_type, index_type);
+}
+
+void Application::draw_multi_indices(
+  std::span<IndexRange const> ranges, std::span<size_t const> base_vertices, DrawType draw_type, IndexType index_type)
+{
+    if (base_vertices.size() != ranges.size()) {
+        throw std::runtime_error(fmt::format("Expected {} base vertices, got {}", ranges.size(), base_vertices.size()));
+    }
+
+    size_t const index_size = index_type == UnsignedShort ? sizeof(GLushort) : sizeof(GLuint);
+
+    multi_draw_counts_.clear();
+    multi_draw_offsets_.clear();
+    multi_draw_base_vertices_.clear();
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        multi_draw_counts_.push_back(gsl::narrow<GLsizei>(ranges[i].index_count));
+        // NOLINTNEXTLINE(performance-no-int-to-ptr): has to be a pointer for glMultiDrawElements
+        multi_draw_offsets_.push_back(reinterpret_cast<void const*>(ranges[i].offset_count * index_size));
+        multi_draw_base_vertices_.push_back(gsl::narrow<GLint>(base_vertices[i]));
+    }
+    draw_multi_ranges(draw_type, index_type);
+}
+
+void Application::draw_multi_ranges(DrawType draw_type, IndexType index_type)
+{
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
+    glMultiDrawElementsBaseVertex(
+      draw_type,
+      multi_draw_counts_.data(),
+      index_type,
+      multi_draw_offsets_.data(),
+      gsl::narrow<GLsizei>(multi_draw_counts_.size()),
+      multi_draw_base_vertices_.data());
 }
 
 void Application::process_window_resize(int width, int height)
@@ -299,11 +483,15 @@ void Application::process_window_resize(int width, int height)
 
 GLint Application::get_uniform_location(std::string const& name)
 {
-    GLint const id = glGetUniformLocation(current_program_id_, name.c_str());
-    if (id < 0) {
-        throw std::runtime_error(fmt::format("Uniform name `{}` is not found", name));
+    return current_program()->uniform_location(name);
+}
+
+Program const* Application::current_program() const
+{
+    if (current_program_ == nullptr) {
+        throw std::runtime_error("No program is in use");
     }
-    return id;
+    return current_program_;
 }
 
 } // namespace playground
@@ -1,15 +1,19 @@
 #ifndef PLAYGROUND_APPLICATION_HPP
 #define PLAYGROUND_APPLICATION_HPP
 
+#include <span>
 #include <string>
 #include <unordered_set>
 #include <memory>
+#include <vector>
 
 #include <SDL2/SDL.h>
 #include <glad/glad.h>
 #include <glm/mat4x4.hpp>
 
+#include "frame_capture.hpp"
 #include "program.hpp"
+#include "stream_buffer.hpp"
 
 namespace playground {
 
@@ -21,6 +25,26 @@ public:
         Lines = GL_LINES
     };
 
+    enum IndexType {
+        UnsignedShort = GL_UNSIGNED_SHORT,
+        UnsignedInt = GL_UNSIGNED_INT
+    };
+
+    // a scoped enum, as the names of the integer types clash with `IndexType`
+    enum class AttributeType {
+        Float = GL_FLOAT,
+        HalfFloat = GL_HALF_FLOAT,
+        Short = GL_SHORT,
+        UnsignedShort = GL_UNSIGNED_SHORT,
+        Int2101010Rev = GL_INT_2_10_10_10_REV
+    };
+
+    // a range of the IBO, see `draw_multi_indices`
+    struct IndexRange {
+        size_t offset_count{};
+        size_t index_count{};
+    };
+
     enum KeyModifiers {
         None = 0,
         Ctrl = 1 << 0,
@@ -42,6 +66,20 @@ public:
 
     void use_program(Program const& p);
 
+    /*
+     * captures every following frame as rendered by `render`, without the UI,
+     * until `stop_capture`. A capture already running is stopped first
+     */
+    void start_capture(CaptureOptions options);
+
+    // waits for the frames still read back or encoded
+    void stop_capture();
+
+    [[nodiscard]] bool capturing() const { return capture_ != nullptr; }
+
+    // of the running capture or the last one
+    [[nodiscard]] CaptureStats capture_stats() const;
+
 protected:
     virtual void update() {}
 
@@ -65,6 +103,12 @@ protected:
 
     void assign_vbo(GLint attribute_location, int components, size_t stride, size_t offset);
 
+    /*
+     * Integer attributes are converted to floats in the shader,
+     * `normalized` maps them onto [0, 1] for unsigned and [-1, 1] for signed types
+     */
+    void assign_vbo(GLint attribute_location, int components, AttributeType type, bool normalized, size_t stride, size_t offset);
+
     /*
      * **Note:** OpenGL uses attribute location (GLint) to assign VBOs,
      * `name` is only used to retrieve that attribute location from a current program.
@@ -87,10 +131,53 @@ protected:
      */
     void assign_vbo(std::string const& name, int components, size_t stride, size_t offset);
 
+    void assign_vbo(std::string const& name, int components, AttributeType type, bool normalized, size_t stride, size_t offset);
+
+    /*
+     * a VBO for vertices written anew every frame, `frame_size` bytes per frame
+     * in three regions, so the GPU reads one frame while the CPU writes the next.
+     * Attributes assigned with `assign_vbo` read from it after `use_stream_vbo`
+     */
+    void alloc_stream_vbo(size_t frame_size);
+
+    /*
+     * memory of the stream VBO to write `size` bytes of vertices into during this frame.
+     * With `alignment` set to the vertex size, `offset / alignment` is the base vertex to draw them
+     */
+    StreamAllocation map_stream_vbo(size_t size, size_t alignment);
+
+    // switches the assigned attributes between the VBO and the stream VBO, within a frame too
+    void use_vbo();
+    void use_stream_vbo();
+
+    [[nodiscard]] StreamBufferStats stream_vbo_stats() const;
+
+    /*
+     * a shader storage buffer written anew every frame like the stream VBO,
+     * for the data of the draws, e.g. read by the shaders at `gl_DrawID`.
+     * Every allocation is aligned to `stream_storage_alignment` within the frame
+     */
+    void alloc_stream_storage(size_t frame_size);
+
+    /*
+     * memory of the stream storage buffer to write `size` bytes into during this frame,
+     * bound to the storage block at `binding` for the following draws
+     */
+    StreamAllocation map_stream_storage(GLuint binding, size_t size);
+
+    [[nodiscard]] size_t stream_storage_alignment() const { return storage_alignment_; }
+
+    [[nodiscard]] StreamBufferStats stream_storage_stats() const;
+
     void alloc_ibo(size_t size);
 
     void upload_ibo(void const* data, size_t offset, size_t size_bytes);
 
+    /*
+     * set a uniform of the current program by name, the name is looked up among the
+     * program's reflected uniforms on every call. Uniforms set every frame are
+     * cheaper through the handles of `Program::uniform`
+     */
     [[maybe_unused]] void set_uniform_data(std::string const& name, float const& data);
 
     [[maybe_unused]] void set_uniform_data(std::string const& name, GLuint const& data);
@@ -101,9 +188,31 @@ protected:
 
     [[maybe_unused]] void set_uniform_data(std::string const& name, glm::vec3 const& data);
 
+    [[maybe_unused]] void set_uniform_data(std::string const& name, glm::vec4 const& data);
+
     [[maybe_unused]] void draw_simple_vertices(size_t vertex_count, DrawType draw_type = Triangles);
 
-    [[maybe_unused]] void draw_indices(size_t vertex_count, DrawType draw_type = Triangles, size_t offset_count = 0);
+    /*
+     * Draws `index_count` indices starting at index `offset_count` of the IBO.
+     * `base_vertex` is added to every index before fetching the vertex, that lets
+     * shapes keep indices local to themselves while sharing one VBO.
+     */
+    [[maybe_unused]] void draw_indices(size_t index_count, DrawType draw_type = Triangles, size_t offset_count = 0,
+      size_t base_vertex = 0, IndexType index_type = UnsignedInt);
+
+    /*
+     * Draws several ranges of the IBO with a single call,
+     * all of them share the same `base_vertex`
+     */
+    [[maybe_unused]] void draw_multi_indices(std::span<IndexRange const> ranges, DrawType draw_type = Triangles,
+      size_t base_vertex = 0, IndexType index_type = UnsignedInt);
+
+    /*
+     * the same, but every range has its own base vertex, so ranges of several
+     * shapes go into one call. Shaders tell the ranges apart by `gl_DrawID`
+     */
+    [[maybe_unused]] void draw_multi_indices(std::span<IndexRange const> ranges, std::span<size_t const> base_vertices,
+      DrawType draw_type = Triangles, IndexType index_type = UnsignedInt);
 
 private:
     bool keep_running_{true};
@@ -121,13 +230,33 @@ private:
     uint32_t vbo_{};
     uint32_t ibo_{};
 
+    std::unique_ptr<StreamBuffer> stream_vbo_{};
+    bool stream_vbo_used_{false};
+    size_t vertex_stride_{};
+
+    std::unique_ptr<StreamBuffer> stream_storage_{};
+    size_t storage_alignment_{1};
+
     std::unordered_set<GLint> created_attributes_;
 
-    GLuint current_program_id_{};
+    // arguments of glMultiDrawElementsBaseVertex, kept to avoid allocations every frame
+    std::vector<GLsizei> multi_draw_counts_{};
+    std::vector<void const*> multi_draw_offsets_{};
+    std::vector<GLint> multi_draw_base_vertices_{};
+
+    Program const* current_program_{};
+
+    std::unique_ptr<FrameCapture> capture_{};
+    CaptureStats last_capture_stats_{};
 
     void process_window_resize(int width, int height);
 
     GLint get_uniform_location(std::string const& name);
+
+    // the ranges and base vertices are in the `multi_draw_` vectors
+    void draw_multi_ranges(DrawType draw_type, IndexType index_type);
+
+    [[nodiscard]] Program const* current_program() const;
 };
 
 } // namespace playground
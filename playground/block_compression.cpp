@@ -0,0 +1,313 @@
+#include "block_compression.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+namespace playground {
+
+static size_t const block_extent = 4;
+static size_t const block_texels = block_extent * block_extent;
+
+using ColorBlock = std::array<std::array<float, 3>, block_texels>;
+using ChannelBlock = std::array<float, block_texels>;
+
+size_t compressed_block_size(TextureCompression compression)
+{
+    switch (compression) {
+    case TextureCompression::Bc1:
+    case TextureCompression::Bc4:
+        return 8;
+    case TextureCompression::Bc5:
+        return 16;
+    case TextureCompression::None:
+        break;
+    }
+    throw std::runtime_error("Uncompressed textures have no blocks");
+}
+
+size_t compressed_image_size(TextureCompression compression, size_t width, size_t height)
+{
+    auto const blocks_x = (width + block_extent - 1) / block_extent;
+    auto const blocks_y = (height + block_extent - 1) / block_extent;
+    return blocks_x * blocks_y * compressed_block_size(compression);
+}
+
+static uint16_t to_rgb565(std::array<float, 3> const& color)
+{
+    auto const r = static_cast<uint16_t>(std::lround(std::clamp(color[0], 0.0F, 255.0F) * 31.0F / 255.0F));
+    auto const g = static_cast<uint16_t>(std::lround(std::clamp(color[1], 0.0F, 255.0F) * 63.0F / 255.0F));
+    auto const b = static_cast<uint16_t>(std::lround(std::clamp(color[2], 0.0F, 255.0F) * 31.0F / 255.0F));
+    return static_cast<uint16_t>(r << 11 | g << 5 | b);
+}
+
+static std::array<float, 3> from_rgb565(uint16_t color)
+{
+    // expanded the way decoders do, by replicating the high bits
+    auto const r = static_cast<uint32_t>(color >> 11 & 31);
+    auto const g = static_cast<uint32_t>(color >> 5 & 63);
+    auto const b = static_cast<uint32_t>(color & 31);
+    return {
+      static_cast<float>(r << 3 | r >> 2),
+      static_cast<float>(g << 2 | g >> 4),
+      static_cast<float>(b << 3 | b >> 2)};
+}
+
+static float squared_distance(std::array<float, 3> const& a, std::array<float, 3> const& b)
+{
+    auto const dr = a[0] - b[0];
+    auto const dg = a[1] - b[1];
+    auto const db = a[2] - b[2];
+    return dr * dr + dg * dg + db * db;
+}
+
+static void store_le(std::byte* target, uint64_t value, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; ++i) {
+        target[i] = static_cast<std::byte>(value >> (8 * i));
+    }
+}
+
+struct Bc1Fit {
+    uint16_t color0{};
+    uint16_t color1{};
+    uint32_t indices{};
+    float error{};
+};
+
+/*
+ * picks the closest of the four palette colors for every texel; the four-color
+ * mode requires color0 > color1, equal endpoints make a solid block
+ */
+static Bc1Fit fit_bc1_indices(ColorBlock const& colors, uint16_t color0, uint16_t color1)
+{
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    auto const c0 = from_rgb565(color0);
+    auto const c1 = from_rgb565(color1);
+    std::array<std::array<float, 3>, 4> const palette{
+      c0,
+      c1,
+      std::array<float, 3>{(2 * c0[0] + c1[0]) / 3, (2 * c0[1] + c1[1]) / 3, (2 * c0[2] + c1[2]) / 3},
+      std::array<float, 3>{(c0[0] + 2 * c1[0]) / 3, (c0[1] + 2 * c1[1]) / 3, (c0[2] + 2 * c1[2]) / 3}};
+    uint32_t const palette_size = color0 == color1 ? 1 : 4;
+
+    Bc1Fit res{color0, color1, 0, 0.0F};
+    for (size_t i = 0; i < block_texels; ++i) {
+        uint32_t best = 0;
+        for (uint32_t p = 1; p < palette_size; ++p) {
+            if (squared_distance(colors[i], palette[p]) < squared_distance(colors[i], palette[best])) {
+                best = p;
+            }
+        }
+        res.indices |= best << (2 * i);
+        res.error += squared_distance(colors[i], palette[best]);
+    }
+    return res;
+}
+
+/*
+ * the endpoints are the extremes of the colors projected onto the principal
+ * axis, found by a few power iterations on the covariance matrix
+ */
+static void encode_bc1(ColorBlock const& colors, std::byte* target)
+{
+    std::array<float, 3> mean{};
+    for (auto const& color : colors) {
+        for (size_t c = 0; c < 3; ++c) {
+            mean[c] += color[c] / static_cast<float>(block_texels);
+        }
+    }
+
+    std::array<float, 6> covariance{};
+    for (auto const& color : colors) {
+        auto const r = color[0] - mean[0];
+        auto const g = color[1] - mean[1];
+        auto const b = color[2] - mean[2];
+        covariance[0] += r * r;
+        covariance[1] += r * g;
+        covariance[2] += r * b;
+        covariance[3] += g * g;
+        covariance[4] += g * b;
+        covariance[5] += b * b;
+    }
+
+    std::array<float, 3> axis{1.0F, 1.0F, 1.0F};
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        std::array<float, 3> const next{
+          covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+          covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+          covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2]};
+        auto const length = std::max({std::abs(next[0]), std::abs(next[1]), std::abs(next[2])});
+        if (length == 0.0F) {
+            break;
+        }
+        axis = {next[0] / length, next[1] / length, next[2] / length};
+    }
+
+    auto min_projection = std::numeric_limits<float>::max();
+    auto max_projection = std::numeric_limits<float>::lowest();
+    std::array<float, 3> min_color{};
+    std::array<float, 3> max_color{};
+    for (auto const& color : colors) {
+        auto const projection = color[0] * axis[0] + color[1] * axis[1] + color[2] * axis[2];
+        if (projection < min_projection) {
+            min_projection = projection;
+            min_color = color;
+        }
+        if (projection > max_projection) {
+            max_projection = projection;
+            max_color = color;
+        }
+    }
+
+    auto fit = fit_bc1_indices(colors, to_rgb565(max_color), to_rgb565(min_color));
+
+    // endpoints which minimize the squared error for the chosen indices, kept if they do better
+    if (fit.error > 0.0F && fit.color0 != fit.color1) {
+        std::array<float, 4> const weights{1.0F, 0.0F, 2.0F / 3.0F, 1.0F / 3.0F};
+        float aa = 0.0F;
+        float ab = 0.0F;
+        float bb = 0.0F;
+        std::array<float, 3> ax{};
+        std::array<float, 3> bx{};
+        for (size_t i = 0; i < block_texels; ++i) {
+            auto const alpha = weights[fit.indices >> (2 * i) & 3];
+            auto const beta = 1.0F - alpha;
+            aa += alpha * alpha;
+            ab += alpha * beta;
+            bb += beta * beta;
+            for (size_t c = 0; c < 3; ++c) {
+                ax[c] += alpha * colors[i][c];
+                bx[c] += beta * colors[i][c];
+            }
+        }
+
+        auto const determinant = aa * bb - ab * ab;
+        if (std::abs(determinant) > 1e-6F) {
+            std::array<float, 3> end0{};
+            std::array<float, 3> end1{};
+            for (size_t c = 0; c < 3; ++c) {
+                end0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+                end1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+            }
+            auto const refined = fit_bc1_indices(colors, to_rgb565(end0), to_rgb565(end1));
+            if (refined.error < fit.error) {
+                fit = refined;
+            }
+        }
+    }
+
+    store_le(target, fit.color0, 2);
+    store_le(target + 2, fit.color1, 2);
+    store_le(target + 4, fit.indices, 4);
+}
+
+/*
+ * eight-value mode between the minimum and the maximum of the block
+ */
+static void encode_bc4(ChannelBlock const& values, std::byte* target)
+{
+    auto const [min_it, max_it] = std::minmax_element(values.cbegin(), values.cend());
+    auto const value0 = static_cast<uint32_t>(std::lround(*max_it));
+    auto const value1 = static_cast<uint32_t>(std::lround(*min_it));
+
+    uint64_t indices = 0;
+    if (value0 != value1) {
+        std::array<float, 8> palette{static_cast<float>(value0), static_cast<float>(value1)};
+        for (uint32_t p = 1; p < 7; ++p) {
+            palette[p + 1] = static_cast<float>((7 - p) * value0 + p * value1) / 7.0F;
+        }
+
+        for (size_t i = 0; i < block_texels; ++i) {
+            uint64_t best = 0;
+            for (uint64_t p = 1; p < palette.size(); ++p) {
+                if (std::abs(values[i] - palette[p]) < std::abs(values[i] - palette[best])) {
+                    best = p;
+                }
+            }
+            indices |= best << (3 * i);
+        }
+    }
+
+    store_le(target, value0, 1);
+    store_le(target + 1, value1, 1);
+    store_le(target + 2, indices, 6);
+}
+
+std::vector<std::byte> compress_blocks(
+  std::span<uint8_t const> pixels,
+  size_t width,
+  size_t height,
+  size_t channels,
+  TextureCompression compression,
+  size_t thread_count)
+{
+    size_t const required_channels = compression == TextureCompression::Bc1 ? 3 : compression == TextureCompression::Bc5 ? 2 : 1;
+    if (channels < required_channels) {
+        throw std::runtime_error(fmt::format("Expected at least {} channels, got {}", required_channels, channels));
+    }
+    if (pixels.size() != width * height * channels) {
+        throw std::runtime_error("Pixels do not match the size of the image");
+    }
+
+    auto const block_size = compressed_block_size(compression);
+    auto const blocks_x = (width + block_extent - 1) / block_extent;
+    auto const blocks_y = (height + block_extent - 1) / block_extent;
+    std::vector<std::byte> res(blocks_x * blocks_y * block_size);
+
+    auto texel = [&](size_t x, size_t y, size_t channel) {
+        auto const clamped_x = std::min(x, width - 1);
+        auto const clamped_y = std::min(y, height - 1);
+        return static_cast<float>(pixels[(clamped_y * width + clamped_x) * channels + channel]);
+    };
+
+    parallel_for(blocks_y, thread_count, 16, [&](size_t begin, size_t end) {
+        for (size_t block_y = begin; block_y < end; ++block_y) {
+            for (size_t block_x = 0; block_x < blocks_x; ++block_x) {
+                auto* target = res.data() + (block_y * blocks_x + block_x) * block_size;
+
+                auto channel_block = [&](size_t channel) {
+                    ChannelBlock values{};
+                    for (size_t i = 0; i < block_texels; ++i) {
+                        values[i] = texel(block_x * block_extent + i % block_extent, block_y * block_extent + i / block_extent, channel);
+                    }
+                    return values;
+                };
+
+                switch (compression) {
+                case TextureCompression::Bc1: {
+                    ColorBlock colors{};
+                    for (size_t i = 0; i < block_texels; ++i) {
+                        for (size_t c = 0; c < 3; ++c) {
+                            colors[i][c] = texel(block_x * block_extent + i % block_extent, block_y * block_extent + i / block_extent, c);
+                        }
+                    }
+                    encode_bc1(colors, target);
+                    break;
+                }
+                case TextureCompression::Bc4:
+                    encode_bc4(channel_block(0), target);
+                    break;
+                case TextureCompression::Bc5:
+                    encode_bc4(channel_block(0), target);
+                    encode_bc4(channel_block(1), target + 8);
+                    break;
+                case TextureCompression::None:
+                    break;
+                }
+            }
+        }
+    });
+
+    return res;
+}
+
+} // namespace playground
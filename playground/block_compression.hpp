@@ -0,0 +1,43 @@
+#ifndef PLAYGROUND_BLOCK_COMPRESSION_HPP
+#define PLAYGROUND_BLOCK_COMPRESSION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "parallel_for.hpp"
+
+namespace playground {
+
+enum class TextureCompression {
+    None,
+    Bc1, // opaque color, 4 bits per texel, alpha is dropped
+    Bc4, // one channel, 4 bits per texel
+    Bc5, // two channels, e.g. normal maps, 8 bits per texel
+};
+
+// bytes of a 4x4 block of the format
+size_t compressed_block_size(TextureCompression compression);
+
+// bytes of an image of the format, partial blocks at the edges count as whole ones
+size_t compressed_image_size(TextureCompression compression, size_t width, size_t height);
+
+/*******************************************************************************
+ * encodes interleaved 8-bit pixels into blocks in row-major block order,
+ * texels outside of the image replicate the edge. BC1 uses the first three
+ * channels, BC4 the first one and BC5 the first two. Endpoints are fitted
+ * along the principal axis of the block's colors. Rows of blocks are encoded
+ * concurrently
+ ******************************************************************************/
+std::vector<std::byte> compress_blocks(
+  std::span<uint8_t const> pixels,
+  size_t width,
+  size_t height,
+  size_t channels,
+  TextureCompression compression,
+  size_t thread_count = default_thread_count());
+
+} // namespace playground
+
+#endif // PLAYGROUND_BLOCK_COMPRESSION_HPP
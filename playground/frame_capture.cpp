@@ -0,0 +1,233 @@
+#include "frame_capture.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <fmt/core.h>
+#include <gsl/narrow>
+#include <spdlog/spdlog.h>
+
+namespace playground {
+
+// rows of the default framebuffer go bottom to top, the alpha of a window is meaningless
+static std::vector<png::RgbPixel> to_rgb(std::vector<png::RgbaPixel> const& pixels, size_t width, size_t height)
+{
+    std::vector<png::RgbPixel> res(width * height);
+    for (size_t y = 0; y < height; ++y) {
+        auto const* source = pixels.data() + (height - 1 - y) * width;
+        auto* target = res.data() + y * width;
+        for (size_t x = 0; x < width; ++x) {
+            target[x] = {source[x].r, source[x].g, source[x].b};
+        }
+    }
+    return res;
+}
+
+// the Y, U and V planes of a 4:4:4 frame of BT.601 limited range, top to bottom
+static std::vector<uint8_t> to_yuv444(std::vector<png::RgbaPixel> const& pixels, size_t width, size_t height)
+{
+    auto const plane_size = width * height;
+    std::vector<uint8_t> res(plane_size * 3);
+    for (size_t y = 0; y < height; ++y) {
+        auto const* source = pixels.data() + (height - 1 - y) * width;
+        for (size_t x = 0; x < width; ++x) {
+            int const r = source[x].r;
+            int const g = source[x].g;
+            int const b = source[x].b;
+            auto const i = y * width + x;
+            res[i] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            res[plane_size + i] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            res[plane_size * 2 + i] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+    return res;
+}
+
+FrameCapture::FrameCapture(CaptureOptions options) :
+  options_{std::move(options)}, readbacks_(std::max(options_.frames_in_flight, 1UL)), encode_pool_{std::max(options_.encode_threads, 1UL)}
+{
+    if (options_.format == CaptureFormat::Y4m) {
+        auto const path = fmt::format("{}/capture.y4m", options_.directory);
+        y4m_file_.reset(std::fopen(path.c_str(), "wb"));
+        if (!y4m_file_) {
+            throw std::runtime_error(fmt::format("Could not open `{}` for writing", path));
+        }
+    }
+}
+
+FrameCapture::~FrameCapture()
+{
+    finish();
+    for (auto& readback : readbacks_) {
+        // deleting a mapped buffer unmaps it
+        glDeleteBuffers(1, &readback.buffer);
+    }
+    spdlog::info("captured {} frames, {} written, {} dropped, {} failed", captured_frames_, written_frames_, dropped_frames_, failed_frames_);
+}
+
+void FrameCapture::finish()
+{
+    // the oldest readback first, frames are numbered and written in capture order
+    for (size_t i = 0; i < readbacks_.size(); ++i) {
+        auto& readback = readbacks_[(frame_ + i) % readbacks_.size()];
+        try {
+            collect(readback, true);
+        } catch (std::exception const& e) {
+            spdlog::error("frame {} is not captured: {}", readback.index, e.what());
+            ++failed_frames_;
+        }
+    }
+
+    for (auto& encode : encodes_) {
+        encode.wait();
+    }
+    poll_encodes();
+}
+
+void FrameCapture::capture(glm::ivec2 size)
+{
+    poll_encodes();
+
+    // whatever the GPU has finished reading back is picked up, the oldest first
+    for (size_t i = 0; i < readbacks_.size() && encodes_.size() < options_.max_pending_frames; ++i) {
+        if (!collect(readbacks_[(frame_ + i) % readbacks_.size()], false)) {
+            break;
+        }
+    }
+
+    auto& readback = readbacks_[frame_ % readbacks_.size()];
+    auto const width = static_cast<size_t>(std::max(size.x, 0));
+    auto const height = static_cast<size_t>(std::max(size.y, 0));
+    auto const resized = options_.format == CaptureFormat::Y4m && y4m_size_ != glm::ivec2{} && y4m_size_ != size;
+    if (readback.fence != nullptr || resized || width * height == 0) {
+        ++dropped_frames_;
+        return;
+    }
+
+    if (options_.format == CaptureFormat::Y4m && y4m_size_ == glm::ivec2{}) {
+        // the writer has nothing to write yet, nothing races with the header
+        y4m_size_ = size;
+        fmt::print(y4m_file_.get(), "YUV4MPEG2 W{} H{} F{}:1 Ip A1:1 C444\n", size.x, size.y, options_.frame_rate);
+    }
+
+    auto const bytes = width * height * sizeof(png::RgbaPixel);
+    if (readback.capacity < bytes) {
+        allocate(readback, bytes);
+    }
+
+    // RGBA of bytes is the format the framebuffer has, the GPU does not convert it
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadBuffer(GL_BACK);
+    glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.index = frame_++;
+    readback.width = width;
+    readback.height = height;
+}
+
+CaptureStats FrameCapture::stats() const
+{
+    CaptureStats res{captured_frames_, written_frames_, dropped_frames_, encodes_.size(), failed_frames_};
+    for (auto const& readback : readbacks_) {
+        res.pending_frames += readback.fence != nullptr ? 1 : 0;
+    }
+    return res;
+}
+
+bool FrameCapture::collect(Readback& readback, bool wait)
+{
+    if (readback.fence == nullptr) {
+        return true;
+    }
+
+    GLenum status = glClientWaitSync(readback.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, 0);
+    while (wait && status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(readback.fence, 0, std::chrono::nanoseconds{std::chrono::milliseconds{100}}.count());
+    }
+    if (status == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+    if (status == GL_WAIT_FAILED) {
+        throw std::runtime_error(fmt::format("Waiting for the readback of frame {} failed", readback.index));
+    }
+
+    // a single copy out of the ring, the encoders flip and convert the copy
+    std::vector<png::RgbaPixel> pixels(readback.width * readback.height);
+    std::memcpy(pixels.data(), readback.mapped, pixels.size() * sizeof(png::RgbaPixel));
+    encode(readback.index, std::move(pixels), readback.width, readback.height);
+    ++captured_frames_;
+    return true;
+}
+
+void FrameCapture::allocate(Readback& readback, size_t size)
+{
+    if (readback.buffer != 0) {
+        glDeleteBuffers(1, &readback.buffer);
+    }
+
+    // the readbacks are read by the CPU only, client storage keeps them in system memory
+    GLbitfield const flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &readback.buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glBufferStorage(GL_PIXEL_PACK_BUFFER, gsl::narrow<GLsizeiptr>(size), nullptr, flags | GL_CLIENT_STORAGE_BIT);
+    readback.mapped = static_cast<std::byte const*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, gsl::narrow<GLsizeiptr>(size), flags));
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (readback.mapped == nullptr) {
+        glDeleteBuffers(1, &readback.buffer);
+        readback.buffer = 0;
+        readback.capacity = 0;
+        throw std::runtime_error(fmt::format("Could not map a frame readback buffer of {} bytes", size));
+    }
+    readback.capacity = size;
+}
+
+void FrameCapture::encode(size_t index, std::vector<png::RgbaPixel> pixels, size_t width, size_t height)
+{
+    if (options_.format == CaptureFormat::Png) {
+        encodes_.push_back(encode_pool_.submit(
+          [path = fmt::format("{}/frame_{:06}.png", options_.directory, index), pixels = std::move(pixels), width, height,
+            level = options_.png_compression_level]() {
+              auto const rgb = to_rgb(pixels, width, height);
+              png::write_png<png::RgbPixel>(path, rgb, width, height, level);
+          }));
+        return;
+    }
+
+    auto planes = encode_pool_.submit([pixels = std::move(pixels), width, height]() {
+        return to_yuv444(pixels, width, height);
+    });
+    encodes_.push_back(writer_pool_.submit([planes = std::move(planes), file = y4m_file_.get()]() mutable {
+        auto const data = planes.get();
+        if (std::fputs("FRAME\n", file) < 0 || std::fwrite(data.data(), 1, data.size(), file) != data.size()) {
+            throw std::runtime_error("Could not write a Y4M frame");
+        }
+    }));
+}
+
+void FrameCapture::poll_encodes()
+{
+    for (auto encode = encodes_.begin(); encode != encodes_.end();) {
+        if (encode->wait_for(std::chrono::seconds{0}) != std::future_status::ready) {
+            ++encode;
+            continue;
+        }
+
+        try {
+            encode->get();
+            ++written_frames_;
+        } catch (std::exception const& e) {
+            spdlog::error("a captured frame is not written: {}", e.what());
+            ++failed_frames_;
+        }
+        encode = encodes_.erase(encode);
+    }
+}
+
+} // namespace playground
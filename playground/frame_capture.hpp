@@ -0,0 +1,114 @@
+#ifndef PLAYGROUND_FRAME_CAPTURE_HPP
+#define PLAYGROUND_FRAME_CAPTURE_HPP
+
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/vec2.hpp>
+
+#include "parallel_for.hpp"
+#include "png.hpp"
+#include "thread_pool.hpp"
+
+namespace playground {
+
+enum class CaptureFormat {
+    Png, // a file per frame, `frame_000000.png` and on
+    Y4m // a single `capture.y4m` of 4:4:4 frames, frames of other sizes than the first are dropped
+};
+
+struct CaptureOptions {
+    std::string directory{"."};
+    CaptureFormat format{CaptureFormat::Png};
+    size_t frames_in_flight{3}; // read back by the GPU while the CPU renders the next ones
+    size_t max_pending_frames{8}; // read back but not written yet, further frames are dropped
+    size_t encode_threads{std::max(default_thread_count() / 2, 1UL)};
+    int png_compression_level{1}; // favours the encode time, captures are big anyway
+    int frame_rate{60}; // written to the Y4M header only
+};
+
+struct CaptureStats {
+    size_t captured_frames{}; // read back and handed to the encoders
+    size_t written_frames{};
+    size_t dropped_frames{}; // the readbacks or the encoders were behind
+    size_t pending_frames{}; // being read back or encoded
+    size_t failed_frames{};
+};
+
+/*******************************************************************************
+ * captures the default framebuffer without stalling the render loop.
+ * Frames are read back into a ring of persistently mapped pixel pack buffers,
+ * a frame is picked up from the CPU once the fence of its readback is
+ * signaled, a few frames later, and encoded on the worker threads. When the
+ * readbacks or the encoders fall behind, frames are dropped rather than waited
+ * for, so capturing adds at most a frame copy to a frame.
+ * Runs on the GL thread only, `capture` is called after the frame is rendered
+ * and before the buffers are swapped
+ ******************************************************************************/
+class FrameCapture final {
+public:
+    explicit FrameCapture(CaptureOptions options);
+
+    // finishes the frames in flight
+    ~FrameCapture();
+
+    FrameCapture(FrameCapture const&) = delete;
+    FrameCapture(FrameCapture&&) = delete;
+    FrameCapture& operator=(FrameCapture const&) = delete;
+    FrameCapture& operator=(FrameCapture&&) = delete;
+
+    void capture(glm::ivec2 size);
+
+    // waits for the frames being read back or encoded and writes them, blocks the caller
+    void finish();
+
+    [[nodiscard]] CaptureStats stats() const;
+
+private:
+    struct Readback {
+        GLuint buffer{};
+        std::byte const* mapped{};
+        size_t capacity{};
+        GLsync fence{};
+        size_t index{}; // of the frame in the capture
+        size_t width{};
+        size_t height{};
+    };
+
+    // hands the readback over to the encoders unless `wait` is false and the GPU is not done yet
+    bool collect(Readback& readback, bool wait);
+
+    void allocate(Readback& readback, size_t size);
+
+    void encode(size_t index, std::vector<png::RgbaPixel> pixels, size_t width, size_t height);
+
+    // drops the finished encodes, an encode throwing is logged and counted as a failure
+    void poll_encodes();
+
+    CaptureOptions options_{};
+    std::vector<Readback> readbacks_{};
+    size_t frame_{};
+    size_t captured_frames_{};
+    size_t written_frames_{};
+    size_t dropped_frames_{};
+    size_t failed_frames_{};
+
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> y4m_file_{nullptr, &std::fclose};
+    glm::ivec2 y4m_size_{};
+
+    std::deque<std::future<void>> encodes_{};
+
+    // Y4M frames are converted concurrently and written in capture order by the single writer
+    ThreadPool encode_pool_;
+    ThreadPool writer_pool_{1};
+};
+
+} // namespace playground
+
+#endif // PLAYGROUND_FRAME_CAPTURE_HPP
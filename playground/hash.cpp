@@ -0,0 +1,57 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "hash.hpp"
+
+namespace playground {
+
+// constants and finalizer of the 64-bit MurmurHash3 / splitmix family
+static uint64_t mix(uint64_t h)
+{
+    h ^= h >> 33U;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33U;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33U;
+    return h;
+}
+
+uint64_t hash_bytes(std::span<std::byte const> data, uint64_t seed)
+{
+    static uint64_t const multiplier = 0x9e3779b97f4a7c15ULL;
+
+    // four independent lanes let the CPU overlap the multiplications
+    std::array<uint64_t, 4> lanes{seed, seed + 1, seed + 2, seed + 3};
+    size_t const block_size = sizeof(uint64_t) * lanes.size();
+
+    size_t offset = 0;
+    for (; offset + block_size <= data.size(); offset += block_size) {
+        for (size_t i = 0; i < lanes.size(); ++i) {
+            uint64_t word{};
+            std::memcpy(&word, data.data() + offset + i * sizeof(uint64_t), sizeof(uint64_t));
+            lanes[i] = (lanes[i] ^ word) * multiplier;
+            lanes[i] ^= lanes[i] >> 29U;
+        }
+    }
+
+    // whatever is left is folded in word by word, the last partial word is zero-padded
+    uint64_t h = data.size();
+    for (; offset < data.size(); offset += sizeof(uint64_t)) {
+        uint64_t word{};
+        std::memcpy(&word, data.data() + offset, std::min(sizeof(uint64_t), data.size() - offset));
+        h = hash_combine(h, word);
+    }
+
+    for (auto lane : lanes) {
+        h = hash_combine(h, lane);
+    }
+    return h;
+}
+
+uint64_t hash_combine(uint64_t a, uint64_t b)
+{
+    return mix(a ^ (mix(b) + 0x9e3779b97f4a7c15ULL + (a << 6U) + (a >> 2U)));
+}
+
+} // namespace playground
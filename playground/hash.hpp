@@ -0,0 +1,23 @@
+#ifndef PLAYGROUND_HASH_HPP
+#define PLAYGROUND_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace playground {
+
+/*******************************************************************************
+ * fast non-cryptographic 64-bit hash of a byte range, good enough to tell
+ * whether a file has changed, not meant to resist deliberate collisions
+ ******************************************************************************/
+uint64_t hash_bytes(std::span<std::byte const> data, uint64_t seed = 0);
+
+/*******************************************************************************
+ * mixes two hashes into one, the order of the arguments matters
+ ******************************************************************************/
+uint64_t hash_combine(uint64_t a, uint64_t b);
+
+} // namespace playground
+
+#endif // PLAYGROUND_HASH_HPP
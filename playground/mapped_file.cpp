@@ -0,0 +1,90 @@
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <fmt/core.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_file.hpp"
+
+namespace playground {
+
+MappedFile::MappedFile(std::string const& file_path, MappedAccess access)
+{
+    int const fd = open(file_path.c_str(), O_RDONLY | O_CLOEXEC); // NOLINT(*-vararg)
+    if (fd == -1) {
+        throw std::runtime_error(fmt::format("could not open the file `{}`", file_path));
+    }
+
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) == -1) {
+        close(fd);
+        throw std::runtime_error(fmt::format("could not stat the file `{}`", file_path));
+    }
+
+    size_ = static_cast<size_t>(file_stat.st_size);
+
+    // mmap refuses zero-length mappings, an empty file is simply an empty view
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) { // NOLINT(*-cstyle-cast, performance-no-int-to-ptr)
+            close(fd);
+            throw std::runtime_error(fmt::format("could not map the file `{}`", file_path));
+        }
+        madvise(data, size_, access == MappedAccess::Sequential ? MADV_SEQUENTIAL : MADV_NORMAL);
+        data_ = static_cast<std::byte const*>(data);
+    }
+
+    // the mapping keeps its own reference to the file
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_) {
+        munmap(const_cast<std::byte*>(data_), size_); // NOLINT(*-const-cast)
+    }
+}
+
+WritableMappedFile::WritableMappedFile(std::string const& file_path, size_t size) :
+  size_{size}
+{
+    int const fd = open(file_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644); // NOLINT(*-vararg)
+    if (fd == -1) {
+        throw std::runtime_error(fmt::format("could not create the file `{}`", file_path));
+    }
+
+    if (ftruncate(fd, static_cast<off_t>(size_)) == -1) {
+        close(fd);
+        throw std::runtime_error(fmt::format("could not resize the file `{}`", file_path));
+    }
+
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) { // NOLINT(*-cstyle-cast, performance-no-int-to-ptr)
+            close(fd);
+            throw std::runtime_error(fmt::format("could not map the file `{}`", file_path));
+        }
+        data_ = static_cast<std::byte*>(data);
+    }
+
+    close(fd);
+}
+
+WritableMappedFile::~WritableMappedFile()
+{
+    if (data_) {
+        munmap(data_, size_);
+    }
+}
+
+std::string temporary_path(std::string const& path)
+{
+    static std::atomic<uint64_t> next_writer{0};
+    return fmt::format("{}.{}.{}.tmp", path, getpid(), next_writer++);
+}
+
+} // namespace playground
@@ -0,0 +1,76 @@
+#ifndef PLAYGROUND_MAPPED_FILE_HPP
+#define PLAYGROUND_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace playground {
+
+// how the mapping is going to be read, the kernel tunes read-ahead accordingly
+enum class MappedAccess {
+    Sequential, // front to back, once
+    Normal, // in any order, with some locality
+};
+
+/*******************************************************************************
+ * read-only memory mapping of a whole file, the mapping lives as long as
+ * the object does, so views returned by `bytes()` and `view()` must not
+ * outlive it
+ ******************************************************************************/
+class MappedFile final {
+public:
+    explicit MappedFile(std::string const& file_path, MappedAccess access = MappedAccess::Sequential);
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    [[nodiscard]] size_t size() const { return size_; }
+
+    [[nodiscard]] std::span<std::byte const> bytes() const { return {data_, size_}; }
+
+    [[nodiscard]] std::string_view view() const { return {reinterpret_cast<char const*>(data_), size_}; }
+
+private:
+    std::byte const* data_{};
+    size_t size_{};
+};
+
+/*******************************************************************************
+ * creates a file of the given size, replacing an existing one, and maps it
+ * for reading and writing. Writes go to the page cache and reach the file
+ * without being held in the process memory, so the file may be larger
+ * than the physical memory
+ ******************************************************************************/
+class WritableMappedFile final {
+public:
+    WritableMappedFile(std::string const& file_path, size_t size);
+    ~WritableMappedFile();
+
+    WritableMappedFile(WritableMappedFile const&) = delete;
+    WritableMappedFile(WritableMappedFile&&) = delete;
+    WritableMappedFile& operator=(WritableMappedFile const&) = delete;
+    WritableMappedFile& operator=(WritableMappedFile&&) = delete;
+
+    [[nodiscard]] size_t size() const { return size_; }
+
+    [[nodiscard]] std::span<std::byte> bytes() const { return {data_, size_}; }
+
+private:
+    std::byte* data_{};
+    size_t size_{};
+};
+
+/*******************************************************************************
+ * a path next to `path` which no other writer, in this process or another one,
+ * is handed out, to write a file into before renaming it over `path`
+ ******************************************************************************/
+std::string temporary_path(std::string const& path);
+
+} // namespace playground
+
+#endif // PLAYGROUND_MAPPED_FILE_HPP
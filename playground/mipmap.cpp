@@ -0,0 +1,244 @@
+#include "mipmap.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <numeric>
+
+namespace playground {
+
+// the filters downsample by two, taps are relative to the first source texel of a target texel
+struct DownsampleKernel {
+    int first_tap{};
+    std::vector<float> weights{};
+};
+
+// values of an image in linear space, channels interleaved
+struct FloatImage {
+    size_t width{};
+    size_t height{};
+    size_t channels{};
+    std::vector<float> values{};
+};
+
+static float srgb_to_linear(float value)
+{
+    return value <= 0.04045F ? value / 12.92F : std::pow((value + 0.055F) / 1.055F, 2.4F);
+}
+
+static float linear_to_srgb(float value)
+{
+    return value <= 0.0031308F ? value * 12.92F : 1.055F * std::pow(value, 1.0F / 2.4F) - 0.055F;
+}
+
+static std::array<float, 256> const& srgb_decode_table()
+{
+    static auto const table = []() {
+        std::array<float, 256> res{};
+        for (size_t i = 0; i < res.size(); ++i) {
+            res[i] = srgb_to_linear(static_cast<float>(i) / 255.0F);
+        }
+        return res;
+    }();
+    return table;
+}
+
+// fine enough that neighbouring dark sRGB values map to distinct entries
+static size_t const srgb_encode_table_size = 1UL << 16;
+
+static std::vector<uint8_t> const& srgb_encode_table()
+{
+    static auto const table = []() {
+        std::vector<uint8_t> res(srgb_encode_table_size);
+        for (size_t i = 0; i < res.size(); ++i) {
+            auto const linear = static_cast<float>(i) / static_cast<float>(srgb_encode_table_size - 1);
+            res[i] = static_cast<uint8_t>(std::lround(linear_to_srgb(linear) * 255.0F));
+        }
+        return res;
+    }();
+    return table;
+}
+
+static bool is_color_channel(size_t channel, size_t channels, ColorSpace color_space)
+{
+    // alpha is coverage, not a color, it stays linear in sRGB images
+    return color_space == ColorSpace::Srgb && !(channels == 4 && channel == 3);
+}
+
+static void to_float(std::span<uint8_t const> bytes, size_t channels, ColorSpace color_space, std::span<float> values)
+{
+    auto const& decode = srgb_decode_table();
+    for (size_t c = 0; c < channels; ++c) {
+        bool const color = is_color_channel(c, channels, color_space);
+        for (size_t i = c; i < bytes.size(); i += channels) {
+            values[i] = color ? decode[bytes[i]] : static_cast<float>(bytes[i]) * (1.0F / 255.0F);
+        }
+    }
+}
+
+static std::vector<uint8_t> to_bytes(FloatImage const& image, ColorSpace color_space)
+{
+    auto const& encode = srgb_encode_table();
+    auto const encode_scale = static_cast<float>(srgb_encode_table_size - 1);
+    std::vector<uint8_t> res(image.values.size());
+    for (size_t c = 0; c < image.channels; ++c) {
+        bool const color = is_color_channel(c, image.channels, color_space);
+        for (size_t i = c; i < res.size(); i += image.channels) {
+            // values are clamped and non-negative, so adding a half rounds to nearest
+            auto const value = std::clamp(image.values[i], 0.0F, 1.0F);
+            res[i] = color
+              ? encode[static_cast<size_t>(value * encode_scale + 0.5F)]
+              : static_cast<uint8_t>(value * 255.0F + 0.5F);
+        }
+    }
+    return res;
+}
+
+static float bessel_i0(float x)
+{
+    // the series converges quickly for the small arguments of the window
+    float sum = 1.0F;
+    float term = 1.0F;
+    for (int k = 1; k < 20; ++k) {
+        term *= (x / (2.0F * static_cast<float>(k))) * (x / (2.0F * static_cast<float>(k)));
+        sum += term;
+    }
+    return sum;
+}
+
+static DownsampleKernel const& downsample_kernel(MipFilter filter)
+{
+    static DownsampleKernel const box{0, {0.5F, 0.5F}};
+
+    // sinc of the halved frequency under a Kaiser window of radius 3 source texels,
+    // source texel centers are at -2.5 .. 2.5 from the center of the target texel
+    static DownsampleKernel const kaiser = []() {
+        float const radius = 3.0F;
+        float const alpha = 4.0F;
+        DownsampleKernel res{-2, {}};
+        for (int tap = 0; tap < 6; ++tap) {
+            auto const x = static_cast<float>(tap) - 2.5F;
+            auto const t = x / radius;
+            auto const window = bessel_i0(alpha * std::sqrt(1.0F - t * t)) / bessel_i0(alpha);
+            auto const sinc = std::sin(std::numbers::pi_v<float> * x / 2.0F) / (std::numbers::pi_v<float> * x / 2.0F);
+            res.weights.push_back(window * sinc);
+        }
+        auto const sum = std::accumulate(res.weights.cbegin(), res.weights.cend(), 0.0F);
+        for (auto& weight : res.weights) {
+            weight /= sum;
+        }
+        return res;
+    }();
+
+    return filter == MipFilter::Box ? box : kaiser;
+}
+
+static size_t clamped_tap(size_t target, int tap, size_t size)
+{
+    auto const source = static_cast<int64_t>(2 * target) + tap;
+    return static_cast<size_t>(std::clamp<int64_t>(source, 0, static_cast<int64_t>(size) - 1));
+}
+
+/*
+ * separable filter, `source_row(y)` returns the values of a row of the source,
+ * so the base level is converted to floating point a row at a time.
+ * The vertical pass works on whole rows, which vectorizes well
+ */
+template <class SourceRow>
+static FloatImage downsample(
+  size_t source_width, size_t source_height, size_t channels, DownsampleKernel const& kernel, SourceRow const& source_row)
+{
+    auto const width = std::max(source_width / 2, 1UL);
+    auto const height = std::max(source_height / 2, 1UL);
+    auto const row_size = width * channels;
+
+    std::vector<float> horizontal(row_size * source_height, 0.0F);
+    for (size_t y = 0; y < source_height; ++y) {
+        float const* source = source_row(y);
+        auto* target = horizontal.data() + y * row_size;
+        for (size_t x = 0; x < width; ++x) {
+            for (size_t k = 0; k < kernel.weights.size(); ++k) {
+                auto const* texel = source + clamped_tap(x, kernel.first_tap + static_cast<int>(k), source_width) * channels;
+                for (size_t c = 0; c < channels; ++c) {
+                    target[x * channels + c] += kernel.weights[k] * texel[c];
+                }
+            }
+        }
+    }
+
+    FloatImage res{width, height, channels, std::vector<float>(row_size * height, 0.0F)};
+    for (size_t y = 0; y < height; ++y) {
+        auto* target = res.values.data() + y * row_size;
+        for (size_t k = 0; k < kernel.weights.size(); ++k) {
+            auto const* source = horizontal.data() + clamped_tap(y, kernel.first_tap + static_cast<int>(k), source_height) * row_size;
+            auto const weight = kernel.weights[k];
+            for (size_t i = 0; i < row_size; ++i) {
+                target[i] += weight * source[i];
+            }
+        }
+    }
+
+    return res;
+}
+
+size_t mip_level_count(size_t width, size_t height)
+{
+    size_t res = 1;
+    for (auto size = std::max(width, height); size > 1; size /= 2) {
+        ++res;
+    }
+    return res;
+}
+
+template <class PixelType>
+std::vector<MipLevel<PixelType>> generate_mipmaps(
+  png::Pixels<PixelType> pixels, size_t width, size_t height, ColorSpace color_space, MipFilter filter)
+{
+    size_t const channels = png::total_channels<PixelType>::value;
+    static_assert(sizeof(PixelType) == png::total_channels<PixelType>::value);
+
+    auto const& kernel = downsample_kernel(filter);
+    auto const bytes = std::span{reinterpret_cast<uint8_t const*>(pixels.data()), pixels.size() * channels};
+
+    std::vector<MipLevel<PixelType>> res{};
+    res.reserve(mip_level_count(width, height));
+    res.push_back({std::move(pixels), width, height});
+
+    auto push_level = [&res, color_space](FloatImage const& image) {
+        auto const level_bytes = to_bytes(image, color_space);
+        png::Pixels<PixelType> level(image.width * image.height);
+        std::memcpy(level.data(), level_bytes.data(), level_bytes.size());
+        res.push_back({std::move(level), image.width, image.height});
+    };
+
+    if (width <= 1 && height <= 1) {
+        return res;
+    }
+
+    std::vector<float> row(width * channels);
+    auto image = downsample(width, height, channels, kernel, [&](size_t y) {
+        to_float(bytes.subspan(y * width * channels, width * channels), channels, color_space, row);
+        return row.data();
+    });
+    push_level(image);
+
+    while (image.width > 1 || image.height > 1) {
+        image = downsample(image.width, image.height, channels, kernel, [&image](size_t y) {
+            return image.values.data() + y * image.width * image.channels;
+        });
+        push_level(image);
+    }
+
+    return res;
+}
+
+template std::vector<MipLevel<png::RedPixel>> generate_mipmaps(
+  png::Pixels<png::RedPixel> pixels, size_t width, size_t height, ColorSpace color_space, MipFilter filter);
+template std::vector<MipLevel<png::RgbPixel>> generate_mipmaps(
+  png::Pixels<png::RgbPixel> pixels, size_t width, size_t height, ColorSpace color_space, MipFilter filter);
+template std::vector<MipLevel<png::RgbaPixel>> generate_mipmaps(
+  png::Pixels<png::RgbaPixel> pixels, size_t width, size_t height, ColorSpace color_space, MipFilter filter);
+
+} // namespace playground
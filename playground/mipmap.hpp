@@ -0,0 +1,46 @@
+#ifndef PLAYGROUND_MIPMAP_HPP
+#define PLAYGROUND_MIPMAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "png.hpp"
+
+namespace playground {
+
+enum class ColorSpace {
+    Linear, // data like specular or normal maps, filtered as is
+    Srgb, // colors are decoded to linear before filtering and encoded back, alpha is linear
+};
+
+enum class MipFilter {
+    Box, // average of 2x2 texels, fast but blurs and aliases a bit
+    Kaiser, // 6-tap windowed sinc, keeps more detail in the smaller levels
+};
+
+template <class PixelType>
+struct MipLevel {
+    png::Pixels<PixelType> pixels{};
+    size_t width{};
+    size_t height{};
+};
+
+/*
+ * number of levels of a full chain down to 1x1
+ */
+size_t mip_level_count(size_t width, size_t height);
+
+/*
+ * the full chain of levels of an image, level 0 is the image itself.
+ * Every level is half the size of the previous one, rounded down, and filtered
+ * from the previous level kept in floating point, so errors do not accumulate
+ */
+template <class PixelType>
+std::vector<MipLevel<PixelType>> generate_mipmaps(
+  png::Pixels<PixelType> pixels, size_t width, size_t height, ColorSpace color_space, MipFilter filter);
+
+} // namespace playground
+
+#endif // PLAYGROUND_MIPMAP_HPP
@@ -0,0 +1,46 @@
+#ifndef PLAYGROUND_PARALLEL_FOR_HPP
+#define PLAYGROUND_PARALLEL_FOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace playground {
+
+inline size_t default_thread_count()
+{
+    return std::max(1U, std::thread::hardware_concurrency());
+}
+
+/*******************************************************************************
+ * splits [0, count) into contiguous ranges of at least `min_range_size`
+ * elements, at most one range per thread, and calls `fn(begin, end)` for
+ * every range concurrently. The calling thread processes the last range
+ * itself. Returns when all ranges are done, the first exception thrown by
+ * `fn` is rethrown
+ ******************************************************************************/
+template <class Function>
+void parallel_for(size_t count, size_t thread_count, size_t min_range_size, Function const& fn)
+{
+    size_t const range_count = std::clamp(count / std::max(min_range_size, 1UL), 1UL, std::max(thread_count, 1UL));
+
+    std::vector<std::future<void>> futures{};
+    futures.reserve(range_count - 1);
+    for (size_t i = 0; i + 1 < range_count; ++i) {
+        futures.push_back(std::async(std::launch::async, [&fn, begin = count * i / range_count, end = count * (i + 1) / range_count]() {
+            fn(begin, end);
+        }));
+    }
+
+    fn(count * (range_count - 1) / range_count, count);
+
+    for (auto& f : futures) {
+        f.get();
+    }
+}
+
+} // namespace playground
+
+#endif // PLAYGROUND_PARALLEL_FOR_HPP
@@ -1,9 +1,12 @@
-#include <array>
-#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
 
 #include <fmt/core.h>
 #include <png.h>
 
+#include "mapped_file.hpp"
 #include "png.hpp"
 
 /* Inspiration *
@@ -14,10 +17,19 @@
 
 namespace png {
 
+// the not yet consumed part of a PNG file in memory
+struct PngSource {
+    std::span<std::byte const> data{};
+};
+
 void read_chunk(png_structp pngptr, png_bytep data, png_size_t size)
 {
-    auto* source = reinterpret_cast<std::ifstream*>(png_get_io_ptr(pngptr));
-    source->read(reinterpret_cast<char*>(data), static_cast<int64_t>(size));
+    auto* source = reinterpret_cast<PngSource*>(png_get_io_ptr(pngptr));
+    if (size > source->data.size()) {
+        png_error(pngptr, "Unexpected end of the PNG data");
+    }
+    std::memcpy(data, source->data.data(), size);
+    source->data = source->data.subspan(size);
 }
 
 // Use RAII for raw C pointers
@@ -51,34 +63,61 @@ struct PngHandle final {
     }
 };
 
-template <class PixelType>
-auto read_png(std::string const& filepath) -> PngData<PixelType>
-{
-    std::ifstream file_stream(filepath, std::ios::binary);
-    if (!file_stream) {
-        throw std::runtime_error("Filed to open the file");
+struct PngWriteHandle final {
+    png_structp pngptr{};
+    png_infop pnginfo{};
+
+    PngWriteHandle() = default;
+    PngWriteHandle(PngWriteHandle const&) = delete;
+    PngWriteHandle(PngWriteHandle&&) = delete;
+
+    auto operator=(PngWriteHandle&&) -> PngWriteHandle& = delete;
+    auto operator=(PngWriteHandle const&) -> PngWriteHandle& = delete;
+
+    ~PngWriteHandle()
+    {
+        png_destroy_write_struct(&pngptr, &pnginfo);
     }
 
-    file_stream.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    void init()
+    {
+        pngptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+        if (!pngptr) {
+            throw std::runtime_error("Failed to create a PNG write structure");
+        }
+
+        pnginfo = png_create_info_struct(pngptr);
+        if (!pnginfo) {
+            throw std::runtime_error("Failed to create a PNG info structure");
+        }
+    }
+};
 
+/*
+ * decodes the header and asks `storage` for width * height pixels to decode into,
+ * only the header is decoded without `storage`
+ */
+static auto decode_png(std::span<std::byte const> data, std::function<png_bytep(PngInfo const&)> const& storage) -> PngInfo
+{
     const size_t header_length = 8;
-    std::array<png_byte, header_length> header{};
-    file_stream.read(reinterpret_cast<char*>(header.data()), header_length);
-    int signature = png_sig_cmp(header.data(), 0, header_length);
-    if (signature != 0) {
+    if (data.size() < header_length || png_sig_cmp(reinterpret_cast<png_const_bytep>(data.data()), 0, header_length) != 0) {
         throw std::runtime_error("Not a PNG file");
     }
 
     PngHandle p{};
     p.init();
 
+    PngSource source{data.subspan(header_length)};
+    PngInfo info{};
+    std::vector<png_bytep> rows{};
+
     // NOLINTNEXTLINE(cert-err52-cpp, hicpp-no-array-decay, cppcoreguidelines-pro-bounds-array-to-pointer-decay)
     if (setjmp(png_jmpbuf(p.pngptr))) {
         // Everything is confirms to RAII, so there is no need to clean up
         throw std::runtime_error("LibPNG Error");
     }
 
-    png_set_read_fn(p.pngptr, reinterpret_cast<png_voidp>(&file_stream), read_chunk);
+    png_set_read_fn(p.pngptr, reinterpret_cast<png_voidp>(&source), read_chunk);
 
     png_set_sig_bytes(p.pngptr, header_length);
     png_set_palette_to_rgb(p.pngptr);
@@ -91,34 +130,147 @@ auto read_png(std::string const& filepath) -> PngData<PixelType>
     int color_type{};
 
     png_get_IHDR(p.pngptr, p.pnginfo, &width, &height, &bit_depth, &color_type, nullptr, nullptr, nullptr);
-    auto channels = png_get_channels(p.pngptr, p.pnginfo);
+    info = {
+      static_cast<size_t>(width),
+      static_cast<size_t>(height),
+      static_cast<size_t>(bit_depth),
+      static_cast<size_t>(color_type),
+      static_cast<size_t>(png_get_channels(p.pngptr, p.pnginfo))};
 
-    size_t expected_channels = total_channels<PixelType>::value;
-    if (channels != expected_channels) {
-        throw std::runtime_error(fmt::format("Expected {} channels but got {}", expected_channels, channels));
+    if (!storage) {
+        return info;
     }
 
-    std::vector<png_bytep> rows(height);
-    Pixels<PixelType> pixels(height * width);
+    // rows are laid out as arrays of pixels of one byte per channel
+    auto const row_size = png_get_rowbytes(p.pngptr, p.pnginfo);
+    if (row_size != info.width * info.channels) {
+        throw std::runtime_error(fmt::format("Unsupported bit depth {}", info.bit_depth));
+    }
 
+    auto* pixels = storage(info);
+    rows.resize(height);
     for (size_t i = 0; i < height; ++i) {
-        auto* row_data = &pixels[width * i];
-        rows[i] = reinterpret_cast<png_bytep>(row_data);
+        rows[i] = pixels + row_size * i;
     }
 
     png_read_image(p.pngptr, rows.data());
 
-    return {
-      std::move(pixels),
-      static_cast<size_t>(width),
-      static_cast<size_t>(height),
-      static_cast<size_t>(bit_depth),
-      static_cast<size_t>(color_type),
-      static_cast<size_t>(channels)};
+    return info;
+}
+
+template <class PixelType>
+static void check_channels(PngInfo const& info)
+{
+    size_t expected_channels = total_channels<PixelType>::value;
+    if (info.channels != expected_channels) {
+        throw std::runtime_error(fmt::format("Expected {} channels but got {}", expected_channels, info.channels));
+    }
+}
+
+template <class PixelType>
+auto read_png(std::string const& filepath) -> PngData<PixelType>
+{
+    // the file is decoded in place, without copying it through a stream
+    playground::MappedFile const file{filepath};
+    return read_png<PixelType>(file.bytes());
+}
+
+template <class PixelType>
+auto read_png(std::span<std::byte const> data) -> PngData<PixelType>
+{
+    Pixels<PixelType> pixels{};
+    auto const info = decode_png(data, [&pixels](PngInfo const& info) {
+        check_channels<PixelType>(info);
+        pixels.resize(info.width * info.height);
+        return reinterpret_cast<png_bytep>(pixels.data());
+    });
+
+    return {std::move(pixels), info.width, info.height, info.bit_depth, info.color_type, info.channels};
+}
+
+template <class PixelType>
+auto read_png(std::span<std::byte const> data, std::span<PixelType> pixels) -> PngInfo
+{
+    return decode_png(data, [pixels](PngInfo const& info) {
+        check_channels<PixelType>(info);
+        if (pixels.size() != info.width * info.height) {
+            throw std::runtime_error(fmt::format(
+              "Expected storage for {}x{} pixels but got {} pixels", info.width, info.height, pixels.size()));
+        }
+        return reinterpret_cast<png_bytep>(pixels.data());
+    });
+}
+
+auto read_png_info(std::span<std::byte const> data) -> PngInfo
+{
+    return decode_png(data, nullptr);
+}
+
+template <class PixelType>
+void write_png(std::string const& filepath, std::span<PixelType const> pixels, size_t width, size_t height, int compression_level)
+{
+    if (pixels.size() != width * height) {
+        throw std::runtime_error(fmt::format("Expected {}x{} pixels but got {} pixels", width, height, pixels.size()));
+    }
+
+    std::unique_ptr<std::FILE, decltype(&std::fclose)> const file{std::fopen(filepath.c_str(), "wb"), &std::fclose};
+    if (!file) {
+        throw std::runtime_error(fmt::format("Could not open `{}` for writing", filepath));
+    }
+
+    PngWriteHandle p{};
+    p.init();
+
+    // libpng takes non-const row pointers, it does not write through them
+    std::vector<png_bytep> rows(height);
+    auto const row_size = width * total_channels<PixelType>::value;
+    for (size_t i = 0; i < height; ++i) {
+        rows[i] = const_cast<png_bytep>(reinterpret_cast<png_const_bytep>(pixels.data())) + row_size * i;
+    }
+
+    int color_type = PNG_COLOR_TYPE_GRAY;
+    if constexpr (total_channels<PixelType>::value == 3) {
+        color_type = PNG_COLOR_TYPE_RGB;
+    } else if constexpr (total_channels<PixelType>::value == 4) {
+        color_type = PNG_COLOR_TYPE_RGBA;
+    }
+
+    // NOLINTNEXTLINE(cert-err52-cpp, hicpp-no-array-decay, cppcoreguidelines-pro-bounds-array-to-pointer-decay)
+    if (setjmp(png_jmpbuf(p.pngptr))) {
+        throw std::runtime_error(fmt::format("LibPNG Error writing `{}`", filepath));
+    }
+
+    png_init_io(p.pngptr, file.get());
+    png_set_compression_level(p.pngptr, compression_level);
+    png_set_IHDR(
+      p.pngptr,
+      p.pnginfo,
+      static_cast<png_uint_32>(width),
+      static_cast<png_uint_32>(height),
+      8,
+      color_type,
+      PNG_INTERLACE_NONE,
+      PNG_COMPRESSION_TYPE_DEFAULT,
+      PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(p.pngptr, p.pnginfo);
+    png_write_image(p.pngptr, rows.data());
+    png_write_end(p.pngptr, nullptr);
 }
 
 template auto read_png<RedPixel>(std::string const& filepath) -> PngData<RedPixel>;
 template auto read_png<RgbPixel>(std::string const& filepath) -> PngData<RgbPixel>;
 template auto read_png<RgbaPixel>(std::string const& filepath) -> PngData<RgbaPixel>;
 
+template auto read_png<RedPixel>(std::span<std::byte const> data) -> PngData<RedPixel>;
+template auto read_png<RgbPixel>(std::span<std::byte const> data) -> PngData<RgbPixel>;
+template auto read_png<RgbaPixel>(std::span<std::byte const> data) -> PngData<RgbaPixel>;
+
+template auto read_png<RedPixel>(std::span<std::byte const> data, std::span<RedPixel> pixels) -> PngInfo;
+template auto read_png<RgbPixel>(std::span<std::byte const> data, std::span<RgbPixel> pixels) -> PngInfo;
+template auto read_png<RgbaPixel>(std::span<std::byte const> data, std::span<RgbaPixel> pixels) -> PngInfo;
+
+template void write_png<RedPixel>(std::string const& filepath, std::span<RedPixel const> pixels, size_t width, size_t height, int compression_level);
+template void write_png<RgbPixel>(std::string const& filepath, std::span<RgbPixel const> pixels, size_t width, size_t height, int compression_level);
+template void write_png<RgbaPixel>(std::string const& filepath, std::span<RgbaPixel const> pixels, size_t width, size_t height, int compression_level);
+
 } // namespace png
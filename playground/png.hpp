@@ -1,6 +1,9 @@
 #ifndef PLAYGROUND_PNG_HPP
 #define PLAYGROUND_PNG_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -58,9 +61,39 @@ struct PngData {
     size_t channels{};
 };
 
+struct PngInfo {
+    size_t width{};
+    size_t height{};
+    size_t bit_depth{};
+    size_t color_type{};
+    size_t channels{};
+};
+
 template <class PixelType>
 auto read_png(std::string const& filepath) -> PngData<PixelType>;
 
+/*
+ * decodes a PNG file which is already in memory, e.g. a mapped file
+ */
+template <class PixelType>
+auto read_png(std::span<std::byte const> data) -> PngData<PixelType>;
+
+/*
+ * decodes the rows straight into the caller's storage of exactly
+ * width * height pixels, e.g. a mapped pixel buffer; `read_png_info` tells the size
+ */
+template <class PixelType>
+auto read_png(std::span<std::byte const> data, std::span<PixelType> pixels) -> PngInfo;
+
+auto read_png_info(std::span<std::byte const> data) -> PngInfo;
+
+/*
+ * encodes width * height pixels, rows top to bottom, of 8 bits per channel.
+ * `compression_level` is zlib's, from 0 (stored) to 9 (smallest but slowest)
+ */
+template <class PixelType>
+void write_png(std::string const& filepath, std::span<PixelType const> pixels, size_t width, size_t height, int compression_level = 6);
+
 } // namespace png
 
 #endif // PLAYGROUND_PNG_HPP
@@ -1,4 +1,8 @@
+#include <algorithm>
+#include <array>
 #include <stdexcept>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 #include <fmt/core.h>
@@ -9,6 +13,112 @@
 
 namespace playground {
 
+static bool is_sampler(GLenum type)
+{
+    switch (type) {
+    case GL_SAMPLER_1D:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_1D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_SAMPLER_CUBE_SHADOW:
+    case GL_SAMPLER_2D_MULTISAMPLE:
+    case GL_SAMPLER_BUFFER:
+    case GL_INT_SAMPLER_2D:
+    case GL_INT_SAMPLER_2D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_2D:
+    case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// whether a uniform of the GLSL type is set from `T`
+template <class T>
+static bool is_uniform_type(GLenum type)
+{
+    if constexpr (std::is_same_v<T, float>) {
+        return type == GL_FLOAT;
+    } else if constexpr (std::is_same_v<T, GLint>) {
+        return type == GL_INT || is_sampler(type);
+    } else if constexpr (std::is_same_v<T, GLuint>) {
+        return type == GL_UNSIGNED_INT;
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return type == GL_BOOL;
+    } else if constexpr (std::is_same_v<T, glm::vec3>) {
+        return type == GL_FLOAT_VEC3;
+    } else if constexpr (std::is_same_v<T, glm::vec4>) {
+        return type == GL_FLOAT_VEC4;
+    } else {
+        static_assert(std::is_same_v<T, glm::mat4>, "Unsupported uniform type");
+        return type == GL_FLOAT_MAT4;
+    }
+}
+
+template <class T>
+void Uniform<T>::set(T const& value) const
+{
+    if (location_ < 0) {
+        return;
+    }
+
+    if constexpr (std::is_same_v<T, float>) {
+        glProgramUniform1f(program_, location_, value);
+    } else if constexpr (std::is_same_v<T, GLint>) {
+        glProgramUniform1i(program_, location_, value);
+    } else if constexpr (std::is_same_v<T, GLuint>) {
+        glProgramUniform1ui(program_, location_, value);
+    } else if constexpr (std::is_same_v<T, bool>) {
+        glProgramUniform1i(program_, location_, value ? 1 : 0);
+    } else if constexpr (std::is_same_v<T, glm::vec3>) {
+        glProgramUniform3fv(program_, location_, 1, glm::value_ptr(value));
+    } else if constexpr (std::is_same_v<T, glm::vec4>) {
+        glProgramUniform4fv(program_, location_, 1, glm::value_ptr(value));
+    } else {
+        glProgramUniformMatrix4fv(program_, location_, 1, GL_FALSE, glm::value_ptr(value));
+    }
+}
+
+/*
+ * the active resources of an interface, uniforms of uniform blocks and
+ * built-in inputs have no location and are left out
+ */
+static std::vector<ProgramResource> reflect_resources(GLuint program, GLenum interface)
+{
+    GLint count{};
+    GLint max_name_length{};
+    glGetProgramInterfaceiv(program, interface, GL_ACTIVE_RESOURCES, &count);
+    glGetProgramInterfaceiv(program, interface, GL_MAX_NAME_LENGTH, &max_name_length);
+
+    auto const is_block = interface == GL_UNIFORM_BLOCK;
+    auto const properties = is_block
+      ? std::array<GLenum, 3>{GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE, GL_NUM_ACTIVE_VARIABLES}
+      : std::array<GLenum, 3>{GL_LOCATION, GL_ARRAY_SIZE, GL_TYPE};
+
+    std::vector<ProgramResource> res{};
+    std::vector<GLchar> name(gsl::narrow<size_t>(std::max(max_name_length, 1)));
+    for (GLuint i = 0; i < gsl::narrow<GLuint>(count); ++i) {
+        std::array<GLint, 3> values{};
+        glGetProgramResourceiv(
+          program, interface, i, gsl::narrow<GLsizei>(properties.size()), properties.data(), gsl::narrow<GLsizei>(values.size()), nullptr, values.data());
+        if (!is_block && values[0] < 0) {
+            continue;
+        }
+
+        glGetProgramResourceName(program, interface, i, gsl::narrow<GLsizei>(name.size()), nullptr, name.data());
+        std::string_view resource_name{name.data()};
+        if (resource_name.ends_with("[0]")) {
+            resource_name.remove_suffix(3);
+        }
+        res.push_back({std::string{resource_name}, values[0], is_block ? GLenum{} : static_cast<GLenum>(values[2]), values[1]});
+    }
+    return res;
+}
+
 Program::Program(std::string const& vertex_shader, std::string const& fragment_shader) :
   vertex_shader_{vertex_shader}, fragment_shader_{fragment_shader}
 {
@@ -42,6 +152,43 @@ void Program::compile()
     is_compiled_ = true;
 }
 
+template <class T>
+Uniform<T> Program::uniform(std::string const& name) const
+{
+    auto const& resource = find_uniform(name);
+    if (!is_uniform_type<T>(resource.type)) {
+        throw std::runtime_error(fmt::format("Uniform `{}` of GL type {:#x} can not be set from the requested type", name, resource.type));
+    }
+    return {program_id_, resource.location};
+}
+
+GLint Program::uniform_location(std::string const& name) const
+{
+    return find_uniform(name).location;
+}
+
+GLint Program::attribute_location(std::string const& name) const
+{
+    auto const attribute = std::find_if(attributes_.begin(), attributes_.end(), [&name](ProgramResource const& attribute) {
+        return attribute.name == name;
+    });
+    if (attribute == attributes_.end()) {
+        throw std::runtime_error(fmt::format("Attribute `{}` is not an active attribute of the program", name));
+    }
+    return attribute->location;
+}
+
+ProgramResource const& Program::find_uniform(std::string const& name) const
+{
+    auto const uniform = std::find_if(uniforms_.begin(), uniforms_.end(), [&name](ProgramResource const& uniform) {
+        return uniform.name == name;
+    });
+    if (uniform == uniforms_.end()) {
+        throw std::runtime_error(fmt::format("Uniform `{}` is not an active uniform of the program", name));
+    }
+    return *uniform;
+}
+
 GLuint Program::get_id() const
 {
     if (!is_compiled_) {
@@ -93,6 +240,31 @@ void Program::link_program()
         glGetProgramInfoLog(program_id_, raw_buffer_size, nullptr, buffer.data());
         throw std::runtime_error(fmt::format("Failed to link shader: {}", buffer.data()));
     }
+
+    reflect();
 }
 
+void Program::reflect()
+{
+    uniforms_ = reflect_resources(program_id_, GL_UNIFORM);
+    attributes_ = reflect_resources(program_id_, GL_PROGRAM_INPUT);
+    uniform_blocks_ = reflect_resources(program_id_, GL_UNIFORM_BLOCK);
+}
+
+template class Uniform<float>;
+template class Uniform<GLint>;
+template class Uniform<GLuint>;
+template class Uniform<bool>;
+template class Uniform<glm::vec3>;
+template class Uniform<glm::vec4>;
+template class Uniform<glm::mat4>;
+
+template Uniform<float> Program::uniform<float>(std::string const& name) const;
+template Uniform<GLint> Program::uniform<GLint>(std::string const& name) const;
+template Uniform<GLuint> Program::uniform<GLuint>(std::string const& name) const;
+template Uniform<bool> Program::uniform<bool>(std::string const& name) const;
+template Uniform<glm::vec3> Program::uniform<glm::vec3>(std::string const& name) const;
+template Uniform<glm::vec4> Program::uniform<glm::vec4>(std::string const& name) const;
+template Uniform<glm::mat4> Program::uniform<glm::mat4>(std::string const& name) const;
+
 } // namespace playground
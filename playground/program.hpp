@@ -3,13 +3,43 @@
 
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 
 namespace playground {
 
+// an active uniform, input attribute or uniform block of a linked program as the driver reports it
+struct ProgramResource {
+    std::string name{}; // arrays are named without the `[0]` of their first element
+    GLint location{-1}; // the binding point of a uniform block
+    GLenum type{}; // e.g. GL_FLOAT_VEC3, none for uniform blocks
+    GLint size{1}; // elements of an array, bytes of a uniform block
+};
+
+/*******************************************************************************
+ * a uniform of a program resolved by name and type once, setting it is a
+ * single glProgramUniform call, whether the program is in use or not.
+ * A default constructed handle sets nothing
+ ******************************************************************************/
+template <class T>
+class Uniform {
+public:
+    Uniform() = default;
+    Uniform(GLuint program, GLint location) : program_{program}, location_{location} {}
+
+    void set(T const& value) const;
+
+    [[nodiscard]] GLint location() const { return location_; }
+
+private:
+    GLuint program_{};
+    GLint location_{-1};
+};
+
 class Program {
 
 public:
@@ -26,10 +56,36 @@ public:
 
     [[nodiscard]] GLuint get_id() const;
 
+    /*
+     * a handle of an active uniform whose GLSL type is set from `T`, e.g. `glm::mat4`
+     * for `mat4` or `GLint` for `int` and samplers. Throws if there is none of the name
+     * or of another type, so a name is validated when the handle is taken, not when it is set
+     */
+    template <class T>
+    [[nodiscard]] Uniform<T> uniform(std::string const& name) const;
+
+    // throws if there is no active uniform of the name
+    [[nodiscard]] GLint uniform_location(std::string const& name) const;
+
+    // throws if there is no active input attribute of the name
+    [[nodiscard]] GLint attribute_location(std::string const& name) const;
+
+    // uniforms in the default block only, members of uniform blocks are set through buffers
+    [[nodiscard]] std::vector<ProgramResource> const& uniforms() const { return uniforms_; }
+
+    [[nodiscard]] std::vector<ProgramResource> const& attributes() const { return attributes_; }
+
+    [[nodiscard]] std::vector<ProgramResource> const& uniform_blocks() const { return uniform_blocks_; }
+
 private:
     void compile_shader(std::string const& source_code, GLuint shader_id);
     void link_program();
 
+    // lists the active resources of the linked program
+    void reflect();
+
+    [[nodiscard]] ProgramResource const& find_uniform(std::string const& name) const;
+
 
     std::string vertex_shader_{};
     std::string fragment_shader_{};
@@ -40,6 +96,9 @@ private:
     GLuint vertex_shader_id_{};
     GLuint fragment_shader_id_{};
 
+    std::vector<ProgramResource> uniforms_{};
+    std::vector<ProgramResource> attributes_{};
+    std::vector<ProgramResource> uniform_blocks_{};
 };
 
 } // namespace playground
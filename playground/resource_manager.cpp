@@ -0,0 +1,83 @@
+#include "resource_manager.hpp"
+
+namespace playground {
+
+ResourceManager::ResourceManager(ResourceSize budget)
+{
+    stats_.budget = budget;
+}
+
+std::shared_ptr<void> ResourceManager::lookup(Key const& key)
+{
+    std::lock_guard const lock{mutex_};
+
+    auto it = entries_.find(key);
+    if (it == entries_.end()) {
+        ++stats_.misses;
+        return nullptr;
+    }
+
+    ++stats_.hits;
+    recent_.splice(recent_.begin(), recent_, it->second.recent);
+    return it->second.resource;
+}
+
+std::shared_ptr<void> ResourceManager::insert(Key const& key, std::shared_ptr<void> resource, ResourceSize size)
+{
+    std::lock_guard const lock{mutex_};
+
+    auto [it, inserted] = entries_.try_emplace(key);
+    if (inserted) {
+        recent_.push_front(key);
+        it->second = {std::move(resource), size, recent_.begin()};
+        stats_.size.cpu_bytes += size.cpu_bytes;
+        stats_.size.gpu_bytes += size.gpu_bytes;
+    }
+
+    return it->second.resource;
+}
+
+void ResourceManager::collect()
+{
+    std::lock_guard const lock{mutex_};
+
+    auto over_cpu_budget = [this]() { return stats_.size.cpu_bytes > stats_.budget.cpu_bytes; };
+    auto over_gpu_budget = [this]() { return stats_.size.gpu_bytes > stats_.budget.gpu_bytes; };
+
+    for (auto it = recent_.end(); it != recent_.begin() && (over_cpu_budget() || over_gpu_budget());) {
+        --it;
+        auto entry = entries_.find(*it);
+        auto const size = entry->second.size;
+
+        // only an entry which frees memory of an exceeded budget is worth evicting
+        bool const frees_budget = (over_cpu_budget() && size.cpu_bytes > 0) || (over_gpu_budget() && size.gpu_bytes > 0);
+        if (entry->second.resource.use_count() == 1 && frees_budget) {
+            stats_.size.cpu_bytes -= size.cpu_bytes;
+            stats_.size.gpu_bytes -= size.gpu_bytes;
+            ++stats_.evictions;
+            entries_.erase(entry);
+            it = recent_.erase(it);
+        }
+    }
+}
+
+void ResourceManager::set_budget(ResourceSize budget)
+{
+    std::lock_guard const lock{mutex_};
+    stats_.budget = budget;
+}
+
+ResourceStats ResourceManager::stats() const
+{
+    std::lock_guard const lock{mutex_};
+
+    auto res = stats_;
+    res.entries = entries_.size();
+    res.referenced_entries = 0;
+    for (auto const& [key, entry] : entries_) {
+        res.referenced_entries += entry.resource.use_count() > 1 ? 1 : 0;
+    }
+    return res;
+}
+
+} // namespace playground
@@ -0,0 +1,119 @@
+#ifndef PLAYGROUND_RESOURCE_MANAGER_HPP
+#define PLAYGROUND_RESOURCE_MANAGER_HPP
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <typeindex>
+#include <utility>
+
+namespace playground {
+
+// memory held by a resource in main memory and on the GPU
+struct ResourceSize {
+    size_t cpu_bytes{};
+    size_t gpu_bytes{};
+};
+
+template <class T>
+struct LoadedResource {
+    std::shared_ptr<T> resource{};
+    ResourceSize size{};
+};
+
+struct ResourceStats {
+    size_t entries{};
+    size_t referenced_entries{};
+    ResourceSize size{};
+    ResourceSize budget{};
+    size_t hits{};
+    size_t misses{};
+    size_t evictions{};
+};
+
+/*******************************************************************************
+ * shares resources of any type by their type and a key, which must describe
+ * everything the resource is built from, e.g. the path and the parameters.
+ * Handles are shared pointers, a resource stays alive as long as a handle
+ * does. Resources nobody holds a handle to stay cached until `collect`
+ * evicts them, least recently used first, to get under the budgets.
+ * `get` may be called from any thread, `collect` is called on the GL thread,
+ * because evicted textures and programs delete their GL objects
+ ******************************************************************************/
+class ResourceManager final {
+public:
+    explicit ResourceManager(ResourceSize budget);
+
+    ResourceManager(ResourceManager const&) = delete;
+    ResourceManager(ResourceManager&&) = delete;
+    ResourceManager& operator=(ResourceManager const&) = delete;
+    ResourceManager& operator=(ResourceManager&&) = delete;
+    ~ResourceManager() = default;
+
+    /*
+     * returns the cached resource or calls `load`, which returns a `LoadedResource<T>`,
+     * and caches its result. Concurrent misses of the same key may both load,
+     * the first one to finish is kept
+     */
+    template <class T, class Load>
+    std::shared_ptr<T> get(std::string const& key, Load const& load);
+
+    /*
+     * returns the cached resource or nothing, e.g. to load missing resources in a batch
+     */
+    template <class T>
+    std::shared_ptr<T> find(std::string const& key);
+
+    void collect();
+
+    void set_budget(ResourceSize budget);
+
+    [[nodiscard]] ResourceStats stats() const;
+
+private:
+    using Key = std::pair<std::type_index, std::string>;
+
+    struct Entry {
+        std::shared_ptr<void> resource{};
+        ResourceSize size{};
+        std::list<Key>::iterator recent{};
+    };
+
+    std::shared_ptr<void> lookup(Key const& key);
+
+    std::shared_ptr<void> insert(Key const& key, std::shared_ptr<void> resource, ResourceSize size);
+
+    mutable std::mutex mutex_{};
+    std::map<Key, Entry> entries_{};
+    std::list<Key> recent_{}; // the most recently used first
+    ResourceStats stats_{};
+};
+
+template <class T, class Load>
+std::shared_ptr<T> ResourceManager::get(std::string const& key, Load const& load)
+{
+    Key const typed_key{std::type_index{typeid(T)}, key};
+    if (auto cached = lookup(typed_key)) {
+        return std::static_pointer_cast<T>(cached);
+    }
+
+    // loading takes long, other resources are served meanwhile;
+    // entries are stored type-erased, constness is restored by the cast on the way out
+    LoadedResource<T> loaded = load();
+    auto resource = std::const_pointer_cast<std::remove_const_t<T>>(std::move(loaded.resource));
+    return std::static_pointer_cast<T>(insert(typed_key, std::move(resource), loaded.size));
+}
+
+template <class T>
+std::shared_ptr<T> ResourceManager::find(std::string const& key)
+{
+    return std::static_pointer_cast<T>(lookup({std::type_index{typeid(T)}, key}));
+}
+
+} // namespace playground
+
+#endif // PLAYGROUND_RESOURCE_MANAGER_HPP
@@ -0,0 +1,86 @@
+#include "stream_buffer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include <fmt/core.h>
+#include <gsl/narrow>
+
+namespace playground {
+
+StreamBuffer::StreamBuffer(GLenum target, size_t frame_size, size_t regions) :
+  frame_size_{frame_size}, fences_(std::max(regions, 1UL), nullptr)
+{
+    stats_.frame_size = frame_size_;
+
+    auto const size = gsl::narrow<GLsizeiptr>(frame_size_ * fences_.size());
+    GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &buffer_);
+    glBindBuffer(target, buffer_);
+    glBufferStorage(target, size, nullptr, flags);
+    mapped_ = static_cast<std::byte*>(glMapBufferRange(target, 0, size, flags));
+    glBindBuffer(target, 0);
+
+    if (mapped_ == nullptr) {
+        glDeleteBuffers(1, &buffer_);
+        throw std::runtime_error(fmt::format("Could not map a stream buffer of {} bytes", size));
+    }
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    for (auto fence : fences_) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+        }
+    }
+    // deleting a mapped buffer unmaps it
+    glDeleteBuffers(1, &buffer_);
+}
+
+void StreamBuffer::begin_frame()
+{
+    stats_.frame_bytes = used_;
+    used_ = 0;
+
+    auto& fence = fences_[frame_ % fences_.size()];
+    if (fence == nullptr) {
+        return;
+    }
+
+    // the region was written `regions` frames ago, the GPU is normally done with it
+    auto status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        ++stats_.stalled_frames;
+        while (status == GL_TIMEOUT_EXPIRED) {
+            status = glClientWaitSync(fence, 0, std::chrono::nanoseconds{std::chrono::milliseconds{1}}.count());
+        }
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+StreamAllocation StreamBuffer::allocate(size_t size, size_t alignment)
+{
+    auto const region = (frame_ % fences_.size()) * frame_size_;
+    auto const offset = (region + used_ + alignment - 1) / alignment * alignment;
+    if (offset + size > region + frame_size_) {
+        throw std::runtime_error(fmt::format("{} bytes exceed the stream buffer frame of {} bytes, {} are used", size, frame_size_, used_));
+    }
+
+    used_ = offset + size - region;
+    return {{mapped_ + offset, size}, offset};
+}
+
+void StreamBuffer::end_frame()
+{
+    // a region without allocations has nothing to wait for
+    if (used_ != 0) {
+        fences_[frame_ % fences_.size()] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    ++frame_;
+}
+
+} // namespace playground
@@ -0,0 +1,66 @@
+#ifndef PLAYGROUND_STREAM_BUFFER_HPP
+#define PLAYGROUND_STREAM_BUFFER_HPP
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace playground {
+
+// mapped memory to write into and its offset in the buffer, valid until the end of the frame
+struct StreamAllocation {
+    std::span<std::byte> data{};
+    size_t offset{};
+};
+
+struct StreamBufferStats {
+    size_t frame_size{};
+    size_t frame_bytes{}; // allocated in the last frame
+    size_t stalled_frames{}; // the GPU was still reading the region when the frame began
+};
+
+/*******************************************************************************
+ * a buffer of `regions` regions of `frame_size` bytes each, persistently and
+ * coherently mapped. Every frame allocates from its own region, the writes go
+ * straight into the memory the GPU reads, without a driver copy. A fence per
+ * region tells when the GPU is done with the frame before the region is
+ * reused `regions` frames later. Runs on the GL thread only
+ ******************************************************************************/
+class StreamBuffer final {
+public:
+    StreamBuffer(GLenum target, size_t frame_size, size_t regions = 3);
+    ~StreamBuffer();
+
+    StreamBuffer(StreamBuffer const&) = delete;
+    StreamBuffer(StreamBuffer&&) = delete;
+    StreamBuffer& operator=(StreamBuffer const&) = delete;
+    StreamBuffer& operator=(StreamBuffer&&) = delete;
+
+    // moves on to the next region, waits for the GPU if it is still reading it
+    void begin_frame();
+
+    // `size` bytes with the offset aligned to `alignment`, throws when the region is full
+    StreamAllocation allocate(size_t size, size_t alignment = 1);
+
+    // fences the region after the commands reading it
+    void end_frame();
+
+    [[nodiscard]] GLuint id() const { return buffer_; }
+
+    [[nodiscard]] StreamBufferStats const& stats() const { return stats_; }
+
+private:
+    GLuint buffer_{};
+    std::byte* mapped_{};
+    size_t frame_size_{};
+    std::vector<GLsync> fences_{};
+    size_t frame_{};
+    size_t used_{};
+    StreamBufferStats stats_{};
+};
+
+} // namespace playground
+
+#endif // PLAYGROUND_STREAM_BUFFER_HPP
@@ -1,5 +1,7 @@
 #include "texture.hpp"
 
+#include <algorithm>
+
 #include <fmt/core.h>
 
 namespace playground {
@@ -20,29 +22,148 @@ GLint get_channels_format(size_t channels)
     }
 }
 
-Texture::Texture(size_t width, size_t height, size_t total_channels, GLenum unit) :
-  total_channels_{total_channels}, unit_{unit}
+// EXT_texture_compression_s3tc, which every desktop driver supports, is not a part of the core profile
+static GLenum const compressed_rgb_s3tc_dxt1 = 0x83F0;
+
+GLenum get_compressed_format(TextureCompression compression)
+{
+    switch (compression) {
+    case TextureCompression::Bc1:
+        return compressed_rgb_s3tc_dxt1;
+    case TextureCompression::Bc4:
+        return GL_COMPRESSED_RED_RGTC1;
+    case TextureCompression::Bc5:
+        return GL_COMPRESSED_RG_RGTC2;
+    case TextureCompression::None:
+        break;
+    }
+    throw std::runtime_error("Uncompressed textures have no compressed format");
+}
+
+void set_texture_filter(GLenum target, TextureFilter filter)
+{
+    switch (filter) {
+    case TextureFilter::Nearest:
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        break;
+    case TextureFilter::Linear:
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        break;
+    case TextureFilter::Trilinear:
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        break;
+    }
+}
+
+Texture::Texture(size_t width, size_t height, size_t total_channels, GLenum unit, size_t levels) :
+  total_channels_{total_channels}, levels_{levels}, width_{width}, height_{height}, unit_{unit}
+{
+    glGenTextures(1, &id_);
+
+    bind();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+    // the texture is complete with fewer levels than a full chain only if the sampler knows
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels_ - 1));
+
+    for (size_t level = 0; level < levels_; ++level) {
+        glTexImage2D(
+          GL_TEXTURE_2D,
+          static_cast<GLint>(level),
+          get_channels_format(total_channels),
+          static_cast<GLint>(std::max(width >> level, 1UL)),
+          static_cast<GLint>(std::max(height >> level, 1UL)),
+          0,
+          get_channels_format(total_channels_),
+          GL_UNSIGNED_BYTE,
+          nullptr);
+    }
+}
+
+Texture::Texture(size_t width, size_t height, TextureCompression compression, GLenum unit, size_t levels) :
+  levels_{levels}, width_{width}, height_{height}, compression_{compression}, unit_{unit}
 {
     glGenTextures(1, &id_);
 
     bind();
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels_ - 1));
 
-    glTexImage2D(
+    glTexStorage2D(
       GL_TEXTURE_2D,
+      static_cast<GLsizei>(levels_),
+      get_compressed_format(compression_),
+      static_cast<GLsizei>(width),
+      static_cast<GLsizei>(height));
+}
+
+void Texture::upload_compressed(std::span<std::byte const> blocks, size_t level)
+{
+    auto const width = std::max(width_ >> level, 1UL);
+    auto const height = std::max(height_ >> level, 1UL);
+    auto const expected_size = compressed_image_size(compression_, width, height);
+    if (blocks.size() != expected_size) {
+        throw std::runtime_error(fmt::format("Expected {} bytes of blocks, got {}", expected_size, blocks.size()));
+    }
+
+    bind();
+    glCompressedTexSubImage2D(
+      GL_TEXTURE_2D,
+      static_cast<GLint>(level),
       0,
-      get_channels_format(total_channels),
-      static_cast<GLint>(width),
-      static_cast<GLint>(height),
       0,
+      static_cast<GLsizei>(width),
+      static_cast<GLsizei>(height),
+      get_compressed_format(compression_),
+      static_cast<GLsizei>(blocks.size()),
+      blocks.data());
+}
+
+void Texture::upload_from_buffer(
+  size_t buffer_offset, size_t size, size_t x_offset, size_t y_offset, size_t width, size_t height, size_t level)
+{
+    // with a bound unpack buffer the data pointer is an offset into the buffer
+    auto const* offset = reinterpret_cast<void const*>(buffer_offset); // NOLINT(performance-no-int-to-ptr)
+
+    bind();
+    if (compression_ != TextureCompression::None) {
+        glCompressedTexSubImage2D(
+          GL_TEXTURE_2D,
+          static_cast<GLint>(level),
+          static_cast<GLint>(x_offset),
+          static_cast<GLint>(y_offset),
+          static_cast<GLsizei>(width),
+          static_cast<GLsizei>(height),
+          get_compressed_format(compression_),
+          static_cast<GLsizei>(size),
+          offset);
+        return;
+    }
+
+    if (size != width * height * total_channels_) {
+        throw std::runtime_error(fmt::format("Expected {} bytes of pixels, got {}", width * height * total_channels_, size));
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(
+      GL_TEXTURE_2D,
+      static_cast<GLint>(level),
+      static_cast<GLint>(x_offset),
+      static_cast<GLint>(y_offset),
+      static_cast<GLsizei>(width),
+      static_cast<GLsizei>(height),
       get_channels_format(total_channels_),
       GL_UNSIGNED_BYTE,
-      nullptr);
+      offset);
 }
 
 template <class PixelType>
-void Texture::upload(PixelType const* data, size_t x_offset, size_t y_offset, size_t width, size_t height)
+void Texture::upload(PixelType const* data, size_t x_offset, size_t y_offset, size_t width, size_t height, size_t level)
 {
     size_t const received_channels = png::total_channels<PixelType>::value;
     if (total_channels_ != received_channels) {
@@ -53,7 +174,7 @@ void Texture::upload(PixelType const* data, size_t x_offset, size_t y_offset, si
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glTexSubImage2D(
       GL_TEXTURE_2D,
-      0,
+      static_cast<GLint>(level),
       static_cast<GLint>(x_offset),
       static_cast<GLint>(y_offset),
       static_cast<GLsizei>(width),
@@ -64,15 +185,27 @@ void Texture::upload(PixelType const* data, size_t x_offset, size_t y_offset, si
 }
 
 template <class PixelType>
-void Texture::upload(png::Pixels<PixelType> const& data, size_t x_offset, size_t y_offset, size_t width, size_t height)
+void Texture::upload(png::Pixels<PixelType> const& data, size_t x_offset, size_t y_offset, size_t width, size_t height, size_t level)
 {
-    upload(data.data(), x_offset, y_offset, width, height);
+    upload(data.data(), x_offset, y_offset, width, height, level);
 }
 
-template void Texture::upload<uint8_t>(png::Pixels<uint8_t> const& data, size_t x_offset, size_t y_offset, size_t width, size_t height);
-template void Texture::upload<png::RedPixel>(png::Pixels<png::RedPixel> const& data, size_t x_offset, size_t y_offset, size_t width, size_t height);
-template void Texture::upload<png::RgbPixel>(png::Pixels<png::RgbPixel> const& data, size_t x_offset, size_t y_offset, size_t width, size_t height);
-template void Texture::upload<png::RgbaPixel>(png::Pixels<png::RgbaPixel> const& data, size_t x_offset, size_t y_offset, size_t width, size_t height);
+template void Texture::upload<uint8_t>(png::Pixels<uint8_t> const& data, size_t x_offset, size_t y_offset, size_t width, size_t height, size_t level);
+template void Texture::upload<png::RedPixel>(png::Pixels<png::RedPixel> const& data, size_t x_offset, size_t y_offset, size_t width, size_t height, size_t level);
+template void Texture::upload<png::RgbPixel>(png::Pixels<png::RgbPixel> const& data, size_t x_offset, size_t y_offset, size_t width, size_t height, size_t level);
+template void Texture::upload<png::RgbaPixel>(png::Pixels<png::RgbaPixel> const& data, size_t x_offset, size_t y_offset, size_t width, size_t height, size_t level);
+
+void Texture::generate_mipmaps()
+{
+    bind();
+    glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+void Texture::set_filter(TextureFilter filter)
+{
+    bind();
+    set_texture_filter(GL_TEXTURE_2D, filter);
+}
 
 void Texture::bind()
 {
@@ -2,17 +2,39 @@
 #define PLAYGROUND_TEXTURE_HPP
 
 #include <cstddef>
+#include <span>
 
 #include <glad/glad.h>
 
+#include "block_compression.hpp"
 #include "png.hpp"
 
 namespace playground {
 
+enum class TextureFilter {
+    Nearest,
+    Linear, // bilinear within the base level
+    Trilinear, // bilinear within and linear between the two closest levels
+};
+
+// the pixel format of uncompressed textures with the number of channels
+GLint get_channels_format(size_t channels);
+
+// the internal format of block-compressed textures
+GLenum get_compressed_format(TextureCompression compression);
+
+// sets the filter of the texture bound to the target
+void set_texture_filter(GLenum target, TextureFilter filter);
+
 class Texture final {
 public:
     Texture() = default;
-    Texture(size_t width, size_t height, size_t total_channels, GLenum unit = GL_TEXTURE0);
+
+    // allocates `levels` levels of halving size, the filter is nearest until `set_filter`
+    Texture(size_t width, size_t height, size_t total_channels, GLenum unit = GL_TEXTURE0, size_t levels = 1);
+
+    // immutable storage of block-compressed levels, filled with `upload_compressed`
+    Texture(size_t width, size_t height, TextureCompression compression, GLenum unit = GL_TEXTURE0, size_t levels = 1);
     ~Texture();
 
     Texture(Texture const&) = delete;
@@ -21,18 +43,48 @@ public:
     Texture& operator=(Texture&&) = delete;
 
     template <class PixelType>
-    void upload(png::Pixels<PixelType> const& data, size_t x_offset, size_t y_offset, size_t width, size_t height);
+    void upload(png::Pixels<PixelType> const& data, size_t x_offset, size_t y_offset, size_t width, size_t height, size_t level = 0);
 
     template <class PixelType>
-    void upload(PixelType const* data, size_t x_offset, size_t y_offset, size_t width, size_t height);
+    void upload(PixelType const* data, size_t x_offset, size_t y_offset, size_t width, size_t height, size_t level = 0);
+
+    // blocks of a whole level, as produced by `compress_blocks`
+    void upload_compressed(std::span<std::byte const> blocks, size_t level = 0);
+
+    /*
+     * the same as `upload` or `upload_compressed`, but the pixels or the blocks are read from
+     * the bound GL_PIXEL_UNPACK_BUFFER, `size` bytes at the offset.
+     * Compressed regions start and end at whole blocks or at the edges of the level
+     */
+    void upload_from_buffer(
+      size_t buffer_offset, size_t size, size_t x_offset, size_t y_offset, size_t width, size_t height, size_t level = 0);
+
+    // builds the levels after the base one on the GPU, not available for compressed textures, an alternative to uploading them
+    void generate_mipmaps();
+
+    void set_filter(TextureFilter filter);
 
     void bind();
     void unbind();
 
     [[nodiscard]] GLuint id() const { return id_; }
 
+    [[nodiscard]] size_t levels() const { return levels_; }
+
+    [[nodiscard]] size_t width() const { return width_; }
+
+    [[nodiscard]] size_t height() const { return height_; }
+
+    [[nodiscard]] size_t channels() const { return total_channels_; }
+
+    [[nodiscard]] TextureCompression compression() const { return compression_; }
+
 private:
     size_t total_channels_{};
+    size_t levels_{1};
+    size_t width_{};
+    size_t height_{};
+    TextureCompression compression_{TextureCompression::None};
 
     GLuint id_{};
     GLenum unit_{};
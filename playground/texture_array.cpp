@@ -0,0 +1,246 @@
+#include "texture_array.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <fmt/core.h>
+
+namespace playground {
+
+static GLenum get_sized_format(size_t channels)
+{
+    switch (channels) {
+    case 1:
+        return GL_R8;
+    case 2:
+        return GL_RG8;
+    case 3:
+        return GL_RGB8;
+    case 4:
+        return GL_RGBA8;
+    default:
+        throw std::runtime_error(fmt::format("Unexpected number of channels: {}", channels));
+    }
+}
+
+// bytes of the rows of a level, partial blocks at the edges count as whole ones
+static size_t rows_size(TextureFormat const& format, size_t width, size_t height)
+{
+    if (format.compression != TextureCompression::None) {
+        return compressed_image_size(format.compression, width, height);
+    }
+    return width * height * format.channels;
+}
+
+TextureArray::TextureArray(TextureFormat const& format, size_t layers, GLenum unit) :
+  format_{format}, layers_{layers}, unit_{unit}
+{
+    allocate();
+}
+
+TextureArray::~TextureArray()
+{
+    glDeleteTextures(1, &id_);
+}
+
+void TextureArray::allocate()
+{
+    glGenTextures(1, &id_);
+
+    bind();
+    set_texture_filter(GL_TEXTURE_2D_ARRAY, filter_);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(loaded_level_ - first_level_));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(format_.levels - first_level_ - 1));
+
+    auto const internal_format = format_.compression == TextureCompression::None
+      ? get_sized_format(format_.channels)
+      : get_compressed_format(format_.compression);
+    glTexStorage3D(
+      GL_TEXTURE_2D_ARRAY,
+      static_cast<GLsizei>(format_.levels - first_level_),
+      internal_format,
+      static_cast<GLsizei>(std::max(format_.width >> first_level_, 1UL)),
+      static_cast<GLsizei>(std::max(format_.height >> first_level_, 1UL)),
+      static_cast<GLsizei>(layers_));
+}
+
+void TextureArray::set_first_level(size_t first_level)
+{
+    if (first_level >= format_.levels) {
+        throw std::runtime_error(fmt::format("Level {} is not a level of a texture array of {} levels", first_level, format_.levels));
+    }
+    if (first_level == first_level_) {
+        return;
+    }
+
+    auto const old_id = id_;
+    auto const old_first_level = first_level_;
+    first_level_ = first_level;
+    loaded_level_ = std::max(loaded_level_, first_level_);
+    allocate();
+
+    for (size_t level = std::max(first_level_, old_first_level); level < format_.levels; ++level) {
+        glCopyImageSubData(
+          old_id,
+          GL_TEXTURE_2D_ARRAY,
+          static_cast<GLint>(level - old_first_level),
+          0,
+          0,
+          0,
+          id_,
+          GL_TEXTURE_2D_ARRAY,
+          static_cast<GLint>(level - first_level_),
+          0,
+          0,
+          0,
+          static_cast<GLsizei>(std::max(format_.width >> level, 1UL)),
+          static_cast<GLsizei>(std::max(format_.height >> level, 1UL)),
+          static_cast<GLsizei>(layers_));
+    }
+    glDeleteTextures(1, &old_id);
+}
+
+void TextureArray::set_loaded_level(size_t level)
+{
+    loaded_level_ = std::clamp(level, first_level_, format_.levels - 1);
+    bind();
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, static_cast<GLint>(loaded_level_ - first_level_));
+}
+
+void TextureArray::upload(size_t layer, size_t level, std::span<std::byte const> data)
+{
+    upload_rows(layer, level, data.data(), data.size(), 0, std::max(format_.height >> level, 1UL));
+}
+
+void TextureArray::upload_from_buffer(size_t layer, size_t level, size_t buffer_offset, size_t size, size_t y_offset, size_t height)
+{
+    // with a bound unpack buffer the data pointer is an offset into the buffer
+    upload_rows(layer, level, reinterpret_cast<void const*>(buffer_offset), size, y_offset, height); // NOLINT(performance-no-int-to-ptr)
+}
+
+void TextureArray::upload_rows(size_t layer, size_t level, void const* data, size_t size, size_t y_offset, size_t height)
+{
+    auto const width = std::max(format_.width >> level, 1UL);
+    auto const expected_size = rows_size(format_, width, height);
+    if (layer >= layers_ || level < first_level_ || level >= format_.levels || size != expected_size) {
+        throw std::runtime_error(fmt::format("Expected {} bytes of a resident level of a layer below {}, got {} bytes of level {} of layer {}",
+          expected_size, layers_, size, level, layer));
+    }
+
+    bind();
+    if (format_.compression != TextureCompression::None) {
+        glCompressedTexSubImage3D(
+          GL_TEXTURE_2D_ARRAY,
+          static_cast<GLint>(level - first_level_),
+          0,
+          static_cast<GLint>(y_offset),
+          static_cast<GLint>(layer),
+          static_cast<GLsizei>(width),
+          static_cast<GLsizei>(height),
+          1,
+          get_compressed_format(format_.compression),
+          static_cast<GLsizei>(size),
+          data);
+        return;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(
+      GL_TEXTURE_2D_ARRAY,
+      static_cast<GLint>(level - first_level_),
+      0,
+      static_cast<GLint>(y_offset),
+      static_cast<GLint>(layer),
+      static_cast<GLsizei>(width),
+      static_cast<GLsizei>(height),
+      1,
+      static_cast<GLenum>(get_channels_format(format_.channels)),
+      GL_UNSIGNED_BYTE,
+      data);
+}
+
+void TextureArray::set_filter(TextureFilter filter)
+{
+    filter_ = filter;
+    bind();
+    set_texture_filter(GL_TEXTURE_2D_ARRAY, filter_);
+}
+
+void TextureArray::bind()
+{
+    glActiveTexture(unit_);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id_);
+}
+
+size_t TextureArray::level_size(size_t level) const
+{
+    return rows_size(format_, std::max(format_.width >> level, 1UL), std::max(format_.height >> level, 1UL));
+}
+
+size_t TextureArray::layer_size() const
+{
+    size_t res = 0;
+    for (size_t level = first_level_; level < format_.levels; ++level) {
+        res += level_size(level);
+    }
+    return res;
+}
+
+TextureArrayPool::TextureArrayPool(size_t layers_per_array, GLenum unit, TextureFilter filter) :
+  layers_per_array_{layers_per_array}, unit_{unit}, filter_{filter} {}
+
+TextureLayer TextureArrayPool::allocate(TextureFormat const& format)
+{
+    auto entry = std::find_if(entries_.begin(), entries_.end(), [&format](Entry const& entry) {
+        return entry.array->format() == format && !entry.free_layers.empty();
+    });
+    if (entry == entries_.end()) {
+        auto array = std::make_shared<TextureArray>(format, layers_per_array_, unit_);
+        array->set_filter(filter_);
+
+        // layers are handed out from the back, so the first one goes first
+        std::vector<size_t> free_layers(layers_per_array_);
+        for (size_t i = 0; i < layers_per_array_; ++i) {
+            free_layers[i] = layers_per_array_ - 1 - i;
+        }
+        entries_.push_back({std::move(array), std::move(free_layers)});
+        entry = std::prev(entries_.end());
+    }
+
+    auto const layer = entry->free_layers.back();
+    entry->free_layers.pop_back();
+    return TextureLayer{entry->array, layer};
+}
+
+void TextureArrayPool::release(TextureLayer const& layer)
+{
+    auto entry = std::find_if(entries_.begin(), entries_.end(), [&layer](Entry const& entry) {
+        return entry.array == layer.array;
+    });
+    if (entry == entries_.end() || std::find(entry->free_layers.begin(), entry->free_layers.end(), layer.layer) != entry->free_layers.end()) {
+        throw std::runtime_error(fmt::format("Layer {} is not allocated from the pool", layer.layer));
+    }
+    entry->free_layers.push_back(layer.layer);
+}
+
+void TextureArrayPool::set_filter(TextureFilter filter)
+{
+    filter_ = filter;
+    for (auto& entry : entries_) {
+        entry.array->set_filter(filter_);
+    }
+}
+
+TextureArrayStats TextureArrayPool::stats() const
+{
+    TextureArrayStats res{};
+    for (auto const& entry : entries_) {
+        res.arrays += 1;
+        res.layers += entry.array->layers();
+        res.used_layers += entry.array->layers() - entry.free_layers.size();
+        res.gpu_bytes += entry.array->layers() * entry.array->layer_size();
+    }
+    return res;
+}
+
+} // namespace playground
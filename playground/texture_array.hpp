@@ -0,0 +1,144 @@
+#ifndef PLAYGROUND_TEXTURE_ARRAY_HPP
+#define PLAYGROUND_TEXTURE_ARRAY_HPP
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "block_compression.hpp"
+#include "texture.hpp"
+
+namespace playground {
+
+// textures of the same format share arrays, `channels` are those of uncompressed formats
+struct TextureFormat {
+    size_t width{};
+    size_t height{};
+    size_t channels{};
+    TextureCompression compression{TextureCompression::None};
+    size_t levels{1};
+
+    bool operator==(TextureFormat const&) const = default;
+};
+
+/*******************************************************************************
+ * a GL_TEXTURE_2D_ARRAY of immutable storage, every layer is a texture
+ * of the format, sampled as `texture(sampler, vec3(uv, layer))`.
+ * Only the levels from the first resident one on have storage, levels are
+ * numbered as in the format regardless of the first resident one
+ ******************************************************************************/
+class TextureArray final {
+public:
+    TextureArray(TextureFormat const& format, size_t layers, GLenum unit = GL_TEXTURE0);
+    ~TextureArray();
+
+    TextureArray(TextureArray const&) = delete;
+    TextureArray(TextureArray&&) = delete;
+    TextureArray& operator=(TextureArray const&) = delete;
+    TextureArray& operator=(TextureArray&&) = delete;
+
+    /*
+     * reallocates the storage for the levels from `first_level` on, the id changes.
+     * Levels resident before and after are copied on the GPU, the new finer ones
+     * are undefined and not sampled until `set_loaded_level` allows it
+     */
+    void set_first_level(size_t first_level);
+
+    // the finest level sampled, coarser than the first resident one while finer ones are uploaded
+    void set_loaded_level(size_t level);
+
+    // a whole level of a layer, pixels or blocks like `Texture::upload` or `Texture::upload_compressed` take them
+    void upload(size_t layer, size_t level, std::span<std::byte const> data);
+
+    // rows of a level of a layer from the bound GL_PIXEL_UNPACK_BUFFER, `size` bytes at the offset
+    void upload_from_buffer(size_t layer, size_t level, size_t buffer_offset, size_t size, size_t y_offset, size_t height);
+
+    void set_filter(TextureFilter filter);
+
+    void bind();
+
+    [[nodiscard]] GLuint id() const { return id_; }
+
+    [[nodiscard]] TextureFormat const& format() const { return format_; }
+
+    [[nodiscard]] size_t layers() const { return layers_; }
+
+    [[nodiscard]] size_t first_level() const { return first_level_; }
+
+    [[nodiscard]] size_t loaded_level() const { return loaded_level_; }
+
+    // bytes of a level of one layer, whether it is resident or not
+    [[nodiscard]] size_t level_size(size_t level) const;
+
+    // bytes of one layer with all of its resident levels
+    [[nodiscard]] size_t layer_size() const;
+
+private:
+    void allocate();
+
+    void upload_rows(size_t layer, size_t level, void const* data, size_t size, size_t y_offset, size_t height);
+
+    TextureFormat format_{};
+    size_t layers_{};
+    size_t first_level_{};
+    size_t loaded_level_{};
+    TextureFilter filter_{TextureFilter::Nearest};
+    GLuint id_{};
+    GLenum unit_{};
+};
+
+/*
+ * a layer of an array of the pool, the array is kept alive by the handle
+ */
+struct TextureLayer {
+    std::shared_ptr<TextureArray> array{};
+    size_t layer{};
+};
+
+struct TextureArrayStats {
+    size_t arrays{};
+    size_t layers{};
+    size_t used_layers{};
+    size_t gpu_bytes{};
+};
+
+/*******************************************************************************
+ * hands out layers of texture arrays, textures of the same format become
+ * layers of the same array, so switching between them changes a layer index
+ * passed to the shader instead of the bound texture. A new array of
+ * `layers_per_array` layers is created once all layers of the format are taken.
+ * Runs on the GL thread only
+ ******************************************************************************/
+class TextureArrayPool final {
+public:
+    TextureArrayPool(size_t layers_per_array, GLenum unit, TextureFilter filter = TextureFilter::Trilinear);
+
+    // a free layer of the format, its contents are undefined until uploaded
+    TextureLayer allocate(TextureFormat const& format);
+
+    // the layer is handed out again by a later `allocate`, arrays are never shrunk
+    void release(TextureLayer const& layer);
+
+    // applies to every array, the existing and the new ones
+    void set_filter(TextureFilter filter);
+
+    [[nodiscard]] TextureArrayStats stats() const;
+
+private:
+    struct Entry {
+        std::shared_ptr<TextureArray> array{};
+        std::vector<size_t> free_layers{};
+    };
+
+    size_t layers_per_array_{};
+    GLenum unit_{};
+    TextureFilter filter_{};
+    std::vector<Entry> entries_{};
+};
+
+} // namespace playground
+
+#endif // PLAYGROUND_TEXTURE_ARRAY_HPP
@@ -0,0 +1,351 @@
+#include "texture_atlas.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+
+#include <fmt/core.h>
+#include <gsl/narrow>
+#include <spdlog/spdlog.h>
+
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <imstb_rectpack.h>
+
+#include "hash.hpp"
+#include "mapped_file.hpp"
+#include "texture_cache.hpp"
+
+namespace playground {
+
+// an image with its gutter, rounded up to the alignment, in texels of level 0
+struct AtlasCell {
+    size_t width{};
+    size_t height{};
+    size_t page{};
+    size_t x{};
+    size_t y{};
+};
+
+/*
+ * places the cells on as many pages as they need, the packer works
+ * in units of the alignment, which keeps the cells aligned and the packer fast
+ */
+static size_t pack_cells(std::vector<AtlasCell>& cells, size_t page_size, size_t alignment)
+{
+    auto const units = gsl::narrow<int>(page_size / alignment);
+
+    std::vector<stbrp_rect> pending(cells.size());
+    for (size_t i = 0; i < cells.size(); ++i) {
+        if (cells[i].width > page_size || cells[i].height > page_size) {
+            throw std::runtime_error(fmt::format("An image of {}x{} texels with its gutter does not fit an atlas page of {}x{}",
+              cells[i].width, cells[i].height, page_size, page_size));
+        }
+        pending[i].id = gsl::narrow<int>(i);
+        pending[i].w = gsl::narrow<stbrp_coord>(cells[i].width / alignment);
+        pending[i].h = gsl::narrow<stbrp_coord>(cells[i].height / alignment);
+    }
+
+    std::vector<stbrp_node> nodes(static_cast<size_t>(units));
+    size_t page_count = 0;
+    while (!pending.empty()) {
+        stbrp_context context{};
+        stbrp_init_target(&context, units, units, nodes.data(), units);
+        stbrp_pack_rects(&context, pending.data(), gsl::narrow<int>(pending.size()));
+
+        // every cell fits an empty page, so every page takes at least one of them
+        std::vector<stbrp_rect> rest{};
+        for (auto const& rect : pending) {
+            if (!rect.was_packed) {
+                rest.push_back(rect);
+                continue;
+            }
+            auto& cell = cells[static_cast<size_t>(rect.id)];
+            cell.page = page_count;
+            cell.x = static_cast<size_t>(rect.x) * alignment;
+            cell.y = static_cast<size_t>(rect.y) * alignment;
+        }
+        pending = std::move(rest);
+        ++page_count;
+    }
+
+    return page_count;
+}
+
+/*
+ * fills the cell's part of a page level with a level of its image,
+ * texels of the gutter repeat the nearest edge texel of the image
+ */
+template <class PixelType>
+static void copy_cell(MipLevel<PixelType> const& source, AtlasCell const& cell, size_t gutter, size_t level, MipLevel<PixelType>& target)
+{
+    auto const cell_x = cell.x >> level;
+    auto const cell_y = cell.y >> level;
+    auto const image_x = static_cast<ptrdiff_t>((cell.x + gutter) >> level);
+    auto const image_y = static_cast<ptrdiff_t>((cell.y + gutter) >> level);
+    auto const max_x = static_cast<ptrdiff_t>(source.width) - 1;
+    auto const max_y = static_cast<ptrdiff_t>(source.height) - 1;
+
+    for (size_t y = cell_y; y < cell_y + (cell.height >> level); ++y) {
+        auto const source_y = static_cast<size_t>(std::clamp(static_cast<ptrdiff_t>(y) - image_y, ptrdiff_t{0}, max_y));
+        auto const* source_row = source.pixels.data() + source_y * source.width;
+        auto* target_row = target.pixels.data() + y * target.width;
+        for (size_t x = cell_x; x < cell_x + (cell.width >> level); ++x) {
+            target_row[x] = source_row[std::clamp(static_cast<ptrdiff_t>(x) - image_x, ptrdiff_t{0}, max_x)];
+        }
+    }
+}
+
+// where the images go, it depends only on their sizes and the options
+struct AtlasLayout {
+    size_t levels{};
+    size_t gutter{};
+    size_t page_count{};
+    std::vector<AtlasCell> cells{};
+    std::vector<AtlasRegion> regions{};
+};
+
+static AtlasLayout layout_atlas(std::vector<std::pair<size_t, size_t>> const& sizes, AtlasOptions const& options)
+{
+    AtlasLayout res{};
+    res.levels = std::min(options.levels, mip_level_count(options.page_size, options.page_size));
+    res.gutter = options.padding << (res.levels - 1);
+    auto const block_size = size_t{options.compression == TextureCompression::None ? 1U : 4U};
+    auto const alignment = block_size << (res.levels - 1);
+    if ((options.page_size & (options.page_size - 1)) != 0 || options.page_size < alignment) {
+        throw std::runtime_error(fmt::format("Atlas pages of {}x{} cannot hold {} levels", options.page_size, options.page_size, res.levels));
+    }
+
+    auto const round_up = [alignment](size_t size) { return (size + alignment - 1) / alignment * alignment; };
+    res.cells.reserve(sizes.size());
+    for (auto const& [width, height] : sizes) {
+        res.cells.push_back({round_up(width + 2 * res.gutter), round_up(height + 2 * res.gutter)});
+    }
+    res.page_count = pack_cells(res.cells, options.page_size, alignment);
+
+    auto const page_size = static_cast<float>(options.page_size);
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        auto const& cell = res.cells[i];
+        res.regions.push_back({cell.page,
+          glm::vec4{
+            static_cast<float>(cell.x + res.gutter) / page_size,
+            static_cast<float>(cell.y + res.gutter) / page_size,
+            static_cast<float>(sizes[i].first) / page_size,
+            static_cast<float>(sizes[i].second) / page_size}});
+    }
+    return res;
+}
+
+template <class PixelType>
+static CompressedImage compress_page(std::vector<MipLevel<PixelType>> const& levels, TextureCompression compression)
+{
+    auto const channels = png::total_channels<PixelType>::value;
+    CompressedImage res{compression, levels.front().width, levels.front().height, {}};
+    for (auto const& level : levels) {
+        auto const pixels = std::span{reinterpret_cast<uint8_t const*>(level.pixels.data()), level.pixels.size() * channels};
+        res.levels.push_back(compress_blocks(pixels, level.width, level.height, channels, compression));
+    }
+    return res;
+}
+
+template <class PixelType>
+TextureAtlas build_atlas(std::vector<MipLevel<PixelType>> images, AtlasOptions const& options)
+{
+    std::vector<std::pair<size_t, size_t>> sizes{};
+    sizes.reserve(images.size());
+    for (auto const& image : images) {
+        sizes.emplace_back(image.width, image.height);
+    }
+    auto layout = layout_atlas(sizes, options);
+    auto const levels = layout.levels;
+    auto const page_count = layout.page_count;
+
+    std::vector<std::vector<MipLevel<PixelType>>> pages(page_count);
+    for (auto& page : pages) {
+        for (size_t level = 0; level < levels; ++level) {
+            auto const size = options.page_size >> level;
+            page.push_back({png::Pixels<PixelType>(size * size, PixelType{}), size, size});
+        }
+    }
+
+    TextureAtlas res{png::total_channels<PixelType>::value, {}, std::move(layout.regions)};
+    size_t covered_texels = 0;
+    for (size_t i = 0; i < images.size(); ++i) {
+        auto const& cell = layout.cells[i];
+        auto const& image = images[i];
+        covered_texels += image.width * image.height;
+
+        auto const chain = generate_mipmaps(std::move(images[i].pixels), image.width, image.height, options.color_space, options.mip_filter);
+        for (size_t level = 0; level < levels; ++level) {
+            copy_cell(chain[std::min(level, chain.size() - 1)], cell, layout.gutter, level, pages[cell.page][level]);
+        }
+    }
+
+    for (auto& page : pages) {
+        if (options.compression == TextureCompression::None) {
+            res.pages.emplace_back(std::move(page));
+        } else {
+            res.pages.emplace_back(compress_page(page, options.compression));
+        }
+    }
+
+    spdlog::info("packed {} images into {} atlas pages of {}x{}, {:.1f}% of them covered",
+      images.size(), page_count, options.page_size, options.page_size,
+      100.0 * static_cast<double>(covered_texels) / static_cast<double>(page_count * options.page_size * options.page_size));
+
+    return res;
+}
+
+static std::string atlas_page_cache_path(std::string const& cache_path, size_t page)
+{
+    return texture_cache_path(fmt::format("{}.{}", cache_path, page));
+}
+
+template <class PixelType>
+AtlasLoader::CachedAtlas AtlasLoader::read_cache(std::vector<MipLevel<PixelType>> const& images,
+  std::vector<std::string> const& paths, AtlasOptions const& options, std::string const& cache_path)
+{
+    // only compressed pages are worth a cache, uncompressed ones take longer to read than to build
+    if (options.compression == TextureCompression::None) {
+        return {};
+    }
+
+    // the sources and every option which changes the pages are a part of the key,
+    // the sizes of the files are read from their headers, they are decoded only to build the atlas
+    auto const channels = png::total_channels<PixelType>::value;
+    uint64_t source_hash = 0;
+    std::vector<std::pair<size_t, size_t>> sizes{};
+    for (auto const& image : images) {
+        source_hash = hash_combine(source_hash, hash_bytes(std::as_bytes(std::span{image.pixels})));
+        source_hash = hash_combine(hash_combine(source_hash, image.width), image.height);
+        sizes.emplace_back(image.width, image.height);
+    }
+    for (auto const& path : paths) {
+        MappedFile const file{path};
+        auto const info = png::read_png_info(file.bytes());
+        source_hash = hash_combine(source_hash, hash_bytes(file.bytes()));
+        sizes.emplace_back(info.width, info.height);
+    }
+    for (auto const option : {options.page_size, options.levels, options.padding, static_cast<size_t>(options.color_space),
+           static_cast<size_t>(options.mip_filter), static_cast<size_t>(options.compression), channels}) {
+        source_hash = hash_combine(source_hash, option);
+    }
+
+    auto layout = layout_atlas(sizes, options);
+    TextureAtlas res{channels, {}, std::move(layout.regions)};
+    for (size_t page = 0; page < layout.page_count; ++page) {
+        auto cached = read_texture_cache(atlas_page_cache_path(cache_path, page), source_hash);
+        if (!cached) {
+            return {source_hash, std::nullopt};
+        }
+        res.pages.emplace_back(std::move(*cached));
+    }
+
+    spdlog::info("read {} atlas pages of `{}` from the cache", layout.page_count, cache_path);
+    return {source_hash, std::move(res)};
+}
+
+void AtlasLoader::write_cache(TextureAtlas const& atlas, uint64_t source_hash, std::string const& cache_path)
+{
+    // the cache is only an optimization, failing to write it is not an error
+    for (size_t page = 0; page < atlas.pages.size(); ++page) {
+        auto const page_path = atlas_page_cache_path(cache_path, page);
+        try {
+            write_texture_cache(page_path, source_hash, std::get<CompressedImage>(atlas.pages[page]));
+        } catch (std::exception const& e) {
+            spdlog::warn("could not write texture cache `{}`: {}", page_path, e.what());
+        }
+    }
+}
+
+template <class PixelType>
+AtlasLoader::AtlasLoader(ThreadPool& pool, std::vector<MipLevel<PixelType>> images, std::vector<std::string> const& paths,
+  AtlasOptions const& options, std::string const& cache_path) :
+  pool_{pool}
+{
+    auto const channels = png::total_channels<PixelType>::value;
+    for (auto const& path : paths) {
+        requests_.push_back({path, channels, GL_TEXTURE0, MipGeneration::None});
+    }
+
+    // both stages on the pool share the images given in memory
+    auto const shared_images = std::make_shared<std::vector<MipLevel<PixelType>> const>(std::move(images));
+    reading_ = pool_.submit([shared_images, paths, options, cache_path]() {
+        return read_cache(*shared_images, paths, options, cache_path);
+    });
+    build_ = [shared_images, options, cache_path](std::vector<DecodedImage> decoded, uint64_t source_hash) {
+        auto sources = *shared_images;
+        for (auto& image : decoded) {
+            sources.push_back(std::move(std::get<std::vector<MipLevel<PixelType>>>(image).front()));
+        }
+
+        auto res = build_atlas(std::move(sources), options);
+        if (options.compression != TextureCompression::None) {
+            write_cache(res, source_hash, cache_path);
+        }
+        return res;
+    };
+}
+
+std::optional<TextureAtlas> AtlasLoader::poll()
+{
+    using namespace std::chrono_literals;
+
+    if (reading_.valid()) {
+        if (reading_.wait_for(0s) != std::future_status::ready) {
+            return std::nullopt;
+        }
+        auto cached = reading_.get();
+        if (cached.atlas) {
+            return std::move(cached.atlas);
+        }
+
+        source_hash_ = cached.source_hash;
+        decoded_.resize(requests_.size());
+        decoding_ = std::make_unique<TextureBatch>(pool_, requests_);
+    }
+
+    if (decoding_) {
+        // the images arrive in the order they finish decoding, they are built in the order of the paths
+        auto const decoded = decoding_->poll_images([this](size_t request, DecodedImage image) {
+            decoded_[request] = std::move(image);
+        });
+        if (!decoded) {
+            return std::nullopt;
+        }
+
+        decoding_.reset();
+        building_ = pool_.submit([build = build_, decoded = std::move(decoded_), source_hash = source_hash_]() mutable {
+            return build(std::move(decoded), source_hash);
+        });
+    }
+
+    if (!building_.valid() || building_.wait_for(0s) != std::future_status::ready) {
+        return std::nullopt;
+    }
+    return building_.get();
+}
+
+TextureRequest atlas_page_request(TextureAtlas const& atlas, GLenum unit, TextureFilter filter)
+{
+    TextureRequest res{};
+    res.channels = atlas.channels;
+    res.unit = unit;
+    res.mipmaps = MipGeneration::Cpu;
+    res.filter = filter;
+    return res;
+}
+
+template TextureAtlas build_atlas(std::vector<MipLevel<png::RedPixel>> images, AtlasOptions const& options);
+template TextureAtlas build_atlas(std::vector<MipLevel<png::RgbPixel>> images, AtlasOptions const& options);
+template TextureAtlas build_atlas(std::vector<MipLevel<png::RgbaPixel>> images, AtlasOptions const& options);
+
+template AtlasLoader::AtlasLoader(ThreadPool& pool, std::vector<MipLevel<png::RedPixel>> images,
+  std::vector<std::string> const& paths, AtlasOptions const& options, std::string const& cache_path);
+template AtlasLoader::AtlasLoader(ThreadPool& pool, std::vector<MipLevel<png::RgbPixel>> images,
+  std::vector<std::string> const& paths, AtlasOptions const& options, std::string const& cache_path);
+template AtlasLoader::AtlasLoader(ThreadPool& pool, std::vector<MipLevel<png::RgbaPixel>> images,
+  std::vector<std::string> const& paths, AtlasOptions const& options, std::string const& cache_path);
+
+} // namespace playground
@@ -0,0 +1,118 @@
+#ifndef PLAYGROUND_TEXTURE_ATLAS_HPP
+#define PLAYGROUND_TEXTURE_ATLAS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/vec4.hpp>
+
+#include "block_compression.hpp"
+#include "mipmap.hpp"
+#include "resource_manager.hpp"
+#include "texture.hpp"
+#include "texture_loader.hpp"
+#include "thread_pool.hpp"
+
+namespace playground {
+
+struct AtlasOptions {
+    size_t page_size{1024}; // width and height of every page, a power of two
+    size_t levels{5}; // levels of every page, smaller images repeat their last level
+    size_t padding{1}; // texels of replicated edges around every image in the last level, doubling in every larger one
+    ColorSpace color_space{ColorSpace::Linear};
+    MipFilter mip_filter{MipFilter::Box};
+    TextureCompression compression{TextureCompression::None}; // images are aligned to whole blocks in every level
+};
+
+/*
+ * where an image lies in the atlas, `uv * uv_rect.zw + uv_rect.xy` maps
+ * uvs within the image to uvs of its page
+ */
+struct AtlasRegion {
+    size_t page{};
+    glm::vec4 uv_rect{0.0F, 0.0F, 1.0F, 1.0F};
+};
+
+struct TextureAtlas {
+    size_t channels{};
+    std::vector<DecodedImage> pages{}; // all levels of every page
+    std::vector<AtlasRegion> regions{}; // in the order of the images
+};
+
+/*******************************************************************************
+ * packs small images into shared pages, so objects using different images
+ * are drawn without rebinding textures. Every image gets its own chain of
+ * levels, which is copied into every level of its page together with a gutter
+ * of replicated edges. Images are aligned to the size of the last level,
+ * so no texel (nor block of a compressed page) of any level is shared
+ * by two images, and filtering never bleeds one image into another
+ ******************************************************************************/
+template <class PixelType>
+TextureAtlas build_atlas(std::vector<MipLevel<PixelType>> images, AtlasOptions const& options);
+
+/*******************************************************************************
+ * builds the atlas of `images` followed by the PNG files at `paths`, driven
+ * by `poll` on the GL thread. Compressed pages are cached at
+ * `texture_cache_path` of `cache_path` and the page number, keyed by the
+ * sources and the options, so an unchanged atlas is read back without
+ * decoding, filtering or encoding any of its images. Otherwise every file is
+ * decoded by its own task of the pool, and the atlas is built on the pool
+ * once all of them are decoded. Tasks never wait for other tasks
+ ******************************************************************************/
+class AtlasLoader final {
+public:
+    template <class PixelType>
+    AtlasLoader(ThreadPool& pool, std::vector<MipLevel<PixelType>> images, std::vector<std::string> const& paths,
+      AtlasOptions const& options, std::string const& cache_path);
+
+    AtlasLoader(AtlasLoader const&) = delete;
+    AtlasLoader(AtlasLoader&&) = delete;
+    AtlasLoader& operator=(AtlasLoader const&) = delete;
+    AtlasLoader& operator=(AtlasLoader&&) = delete;
+
+    /*
+     * advances the loading, returns the atlas once it is read or built.
+     * An error of any stage is rethrown, the loader is done after it
+     */
+    std::optional<TextureAtlas> poll();
+
+private:
+    // the key of the cached pages, the atlas if all of them are up to date
+    struct CachedAtlas {
+        uint64_t source_hash{};
+        std::optional<TextureAtlas> atlas{};
+    };
+
+    using Build = std::function<TextureAtlas(std::vector<DecodedImage> decoded, uint64_t source_hash)>;
+
+    template <class PixelType>
+    static CachedAtlas read_cache(std::vector<MipLevel<PixelType>> const& images, std::vector<std::string> const& paths,
+      AtlasOptions const& options, std::string const& cache_path);
+
+    static void write_cache(TextureAtlas const& atlas, uint64_t source_hash, std::string const& cache_path);
+
+    ThreadPool& pool_;
+    std::vector<TextureRequest> requests_{};
+    Build build_{};
+    std::future<CachedAtlas> reading_{};
+    uint64_t source_hash_{};
+    std::unique_ptr<TextureBatch> decoding_{};
+    std::vector<DecodedImage> decoded_{}; // by request
+    std::future<TextureAtlas> building_{};
+};
+
+/*
+ * the request to create the textures of the pages with, by `stream_texture`
+ */
+TextureRequest atlas_page_request(TextureAtlas const& atlas, GLenum unit, TextureFilter filter);
+
+} // namespace playground
+
+#endif // PLAYGROUND_TEXTURE_ATLAS_HPP
@@ -0,0 +1,129 @@
+#include "texture_cache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+
+#include "hash.hpp"
+#include "mapped_file.hpp"
+
+namespace playground {
+
+// bump the version whenever the layout of the file or the encoders change
+static uint32_t const texture_cache_version = 1;
+static std::array<char, 8> const texture_cache_magic{'P', 'G', 'T', 'E', 'X', '\0', '\0', '\0'};
+
+struct TextureCacheHeader {
+    std::array<char, 8> magic{};
+    uint32_t version{};
+    uint32_t compression{};
+    uint64_t source_hash{};
+    uint64_t payload_hash{};
+    uint64_t width{};
+    uint64_t height{};
+    uint64_t level_count{};
+};
+
+static_assert(std::is_trivially_copyable_v<TextureCacheHeader>);
+static_assert(sizeof(TextureCacheHeader) == 56);
+
+std::string texture_cache_path(std::string const& source_path)
+{
+    return source_path + ".texture";
+}
+
+static size_t level_size(TextureCompression compression, size_t width, size_t height, size_t level)
+{
+    return compressed_image_size(compression, std::max(width >> level, 1UL), std::max(height >> level, 1UL));
+}
+
+std::optional<CompressedImage> read_texture_cache(std::string const& cache_path, uint64_t source_hash)
+{
+    if (!std::filesystem::exists(cache_path)) {
+        return std::nullopt;
+    }
+
+    MappedFile const file{cache_path};
+    auto const bytes = file.bytes();
+
+    TextureCacheHeader header{};
+    if (bytes.size() < sizeof(header)) {
+        spdlog::warn("texture cache `{}` is truncated", cache_path);
+        return std::nullopt;
+    }
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    if (header.magic != texture_cache_magic || header.version != texture_cache_version) {
+        spdlog::info("texture cache `{}` has an outdated format", cache_path);
+        return std::nullopt;
+    }
+
+    if (header.source_hash != source_hash) {
+        spdlog::info("texture cache `{}` is stale", cache_path);
+        return std::nullopt;
+    }
+
+    auto const compression = static_cast<TextureCompression>(header.compression);
+    auto const payload = bytes.subspan(sizeof(header));
+    bool valid = compression == TextureCompression::Bc1 || compression == TextureCompression::Bc4 || compression == TextureCompression::Bc5;
+    valid = valid && header.level_count > 0 && header.level_count <= 64 && playground::hash_bytes(payload) == header.payload_hash;
+
+    size_t payload_size = 0;
+    for (size_t level = 0; valid && level < header.level_count; ++level) {
+        payload_size += level_size(compression, header.width, header.height, level);
+    }
+    if (!valid || payload.size() != payload_size) {
+        spdlog::warn("texture cache `{}` is corrupt", cache_path);
+        return std::nullopt;
+    }
+
+    CompressedImage res{compression, header.width, header.height, {}};
+    size_t offset = 0;
+    for (size_t level = 0; level < header.level_count; ++level) {
+        auto const level_data = payload.subspan(offset, level_size(compression, header.width, header.height, level));
+        res.levels.emplace_back(level_data.begin(), level_data.end());
+        offset += level_data.size();
+    }
+    return res;
+}
+
+void write_texture_cache(std::string const& cache_path, uint64_t source_hash, CompressedImage const& image)
+{
+    // the payload is hashed as one range when it is read back
+    std::vector<std::byte> payload{};
+    for (auto const& level : image.levels) {
+        payload.insert(payload.end(), level.begin(), level.end());
+    }
+
+    TextureCacheHeader const header{
+      texture_cache_magic,
+      texture_cache_version,
+      static_cast<uint32_t>(image.compression),
+      source_hash,
+      playground::hash_bytes(payload),
+      image.width,
+      image.height,
+      image.levels.size()};
+
+    // concurrent writers of the same texture write their own files, the last rename wins
+    auto const temporary_path = playground::temporary_path(cache_path);
+    {
+        std::ofstream out{temporary_path, std::ios::binary | std::ios::trunc};
+        if (!out) {
+            throw std::runtime_error(fmt::format("could not create `{}`", temporary_path));
+        }
+        out.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+        out.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        out.write(reinterpret_cast<char const*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+    }
+    std::filesystem::rename(temporary_path, cache_path);
+}
+
+} // namespace playground
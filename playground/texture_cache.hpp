@@ -0,0 +1,43 @@
+#ifndef PLAYGROUND_TEXTURE_CACHE_HPP
+#define PLAYGROUND_TEXTURE_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "block_compression.hpp"
+
+namespace playground {
+
+// blocks of every level of a texture, level 0 first
+struct CompressedImage {
+    TextureCompression compression{TextureCompression::None};
+    size_t width{};
+    size_t height{};
+    std::vector<std::vector<std::byte>> levels{};
+};
+
+/*******************************************************************************
+ * Encoded textures are stored in a binary file next to their source:
+ * a fixed-size header followed by the blocks of all levels as they are uploaded.
+ * The header records the hash of the source file and of the options the
+ * texture was encoded with, a cache file with a different hash or version
+ * is considered stale
+ ******************************************************************************/
+std::string texture_cache_path(std::string const& source_path);
+
+/*******************************************************************************
+ * reads an encoded texture, returns nothing if the file is missing, stale or corrupt
+ ******************************************************************************/
+std::optional<CompressedImage> read_texture_cache(std::string const& cache_path, uint64_t source_hash);
+
+/*******************************************************************************
+ * writes an encoded texture, the file is replaced atomically
+ ******************************************************************************/
+void write_texture_cache(std::string const& cache_path, uint64_t source_hash, CompressedImage const& image);
+
+} // namespace playground
+
+#endif // PLAYGROUND_TEXTURE_CACHE_HPP
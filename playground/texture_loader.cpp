@@ -0,0 +1,219 @@
+#include "texture_loader.hpp"
+
+#include <chrono>
+#include <stdexcept>
+#include <type_traits>
+
+#include <fmt/core.h>
+#include <spdlog/spdlog.h>
+
+#include "hash.hpp"
+#include "mapped_file.hpp"
+
+namespace playground {
+
+template <class PixelType>
+static std::vector<MipLevel<PixelType>> decode_levels(TextureRequest const& request)
+{
+    auto image = png::read_png<PixelType>(request.path);
+    if (request.mipmaps != MipGeneration::Cpu) {
+        std::vector<MipLevel<PixelType>> res{};
+        res.push_back({std::move(image.pixels), image.width, image.height});
+        return res;
+    }
+    return generate_mipmaps(std::move(image.pixels), image.width, image.height, request.color_space, request.mip_filter);
+}
+
+template <class PixelType>
+static CompressedImage decode_compressed(TextureRequest const& request)
+{
+    // options which change the encoded texture are a part of the key as well
+    auto source_hash = hash_bytes(MappedFile{request.path}.bytes());
+    source_hash = hash_combine(source_hash, request.channels);
+    source_hash = hash_combine(source_hash, static_cast<uint64_t>(request.compression));
+    source_hash = hash_combine(source_hash, static_cast<uint64_t>(request.mipmaps != MipGeneration::None));
+    source_hash = hash_combine(source_hash, static_cast<uint64_t>(request.color_space));
+    source_hash = hash_combine(source_hash, static_cast<uint64_t>(request.mip_filter));
+    auto const cache_path = texture_cache_path(request.path);
+
+    if (auto cached = read_texture_cache(cache_path, source_hash)) {
+        return std::move(*cached);
+    }
+
+    // the GPU cannot generate levels of compressed textures, so they are always generated here
+    auto levels_request = request;
+    if (levels_request.mipmaps == MipGeneration::Gpu) {
+        levels_request.mipmaps = MipGeneration::Cpu;
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+    auto const levels = decode_levels<PixelType>(levels_request);
+    CompressedImage res{request.compression, levels.front().width, levels.front().height, {}};
+    for (auto const& level : levels) {
+        auto const pixels = std::span{reinterpret_cast<uint8_t const*>(level.pixels.data()), level.pixels.size() * request.channels};
+        res.levels.push_back(compress_blocks(pixels, level.width, level.height, request.channels, request.compression));
+    }
+    std::chrono::duration<double> const time = std::chrono::steady_clock::now() - start;
+    spdlog::info("encoded `{}` with {} levels in {:.1f} ms", request.path, res.levels.size(), time.count() * 1000.0);
+
+    // the cache is only an optimization, failing to write it is not an error
+    try {
+        write_texture_cache(cache_path, source_hash, res);
+    } catch (std::exception const& e) {
+        spdlog::warn("could not write texture cache `{}`: {}", cache_path, e.what());
+    }
+
+    return res;
+}
+
+template <class PixelType>
+static DecodedImage decode_image(TextureRequest const& request)
+{
+    if (request.compression != TextureCompression::None) {
+        return decode_compressed<PixelType>(request);
+    }
+    return decode_levels<PixelType>(request);
+}
+
+DecodedImage decode_image(TextureRequest const& request)
+{
+    switch (request.channels) {
+    case 1:
+        return decode_image<png::RedPixel>(request);
+    case 3:
+        return decode_image<png::RgbPixel>(request);
+    case 4:
+        return decode_image<png::RgbaPixel>(request);
+    default:
+        throw std::runtime_error(fmt::format("Unexpected number of channels: {}", request.channels));
+    }
+}
+
+static LoadedResource<Texture> create_compressed_texture(CompressedImage const& image, TextureRequest const& request)
+{
+    auto texture = std::make_shared<Texture>(image.width, image.height, image.compression, request.unit, image.levels.size());
+    size_t gpu_bytes = 0;
+    for (size_t level = 0; level < image.levels.size(); ++level) {
+        texture->upload_compressed(image.levels[level], level);
+        gpu_bytes += image.levels[level].size();
+    }
+    texture->set_filter(request.filter);
+
+    return LoadedResource<Texture>{texture, {0, gpu_bytes}};
+}
+
+template <class PixelType>
+static LoadedResource<Texture> create_texture(std::vector<MipLevel<PixelType>> const& levels, TextureRequest const& request)
+{
+    auto const& base = levels.front();
+    auto const level_count = request.mipmaps == MipGeneration::Gpu ? mip_level_count(base.width, base.height) : levels.size();
+
+    auto texture = std::make_shared<Texture>(base.width, base.height, request.channels, request.unit, level_count);
+    size_t gpu_bytes = 0;
+    for (size_t level = 0; level < levels.size(); ++level) {
+        texture->upload(levels[level].pixels, 0, 0, levels[level].width, levels[level].height, level);
+        gpu_bytes += levels[level].pixels.size() * request.channels;
+    }
+    if (request.mipmaps == MipGeneration::Gpu) {
+        texture->generate_mipmaps();
+        gpu_bytes += gpu_bytes / 3;
+    }
+    texture->set_filter(request.filter);
+
+    return LoadedResource<Texture>{texture, {0, gpu_bytes}};
+}
+
+LoadedResource<Texture> create_texture(DecodedImage const& image, TextureRequest const& request)
+{
+    return std::visit([&request](auto const& data) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(data)>, CompressedImage>) {
+            return create_compressed_texture(data, request);
+        } else {
+            return create_texture(data, request);
+        }
+    }, image);
+}
+
+TextureBatch::TextureBatch(ThreadPool& pool, std::vector<TextureRequest> requests) :
+  requests_{std::move(requests)}
+{
+    tasks_.reserve(requests_.size());
+    for (size_t i = 0; i < requests_.size(); ++i) {
+        tasks_.push_back(pool.submit([this, i]() {
+            Decoded decoded{i, std::nullopt, nullptr};
+            try {
+                decoded.image = decode_image(requests_[i]);
+            } catch (...) {
+                decoded.error = std::current_exception();
+            }
+
+            {
+                std::lock_guard const lock{mutex_};
+                decoded_.push_back(std::move(decoded));
+            }
+            decoded_available_.notify_one();
+        }));
+    }
+}
+
+TextureBatch::~TextureBatch()
+{
+    for (auto& task : tasks_) {
+        task.wait();
+    }
+}
+
+bool TextureBatch::poll(Finish const& finish)
+{
+    return finish_decoded(create_textures(finish), false);
+}
+
+void TextureBatch::finish(Finish const& finish)
+{
+    finish_decoded(create_textures(finish), true);
+}
+
+bool TextureBatch::poll_images(FinishImage const& finish)
+{
+    return finish_decoded(finish, false);
+}
+
+void TextureBatch::finish_images(FinishImage const& finish)
+{
+    finish_decoded(finish, true);
+}
+
+TextureBatch::FinishImage TextureBatch::create_textures(Finish const& finish) const
+{
+    return [this, &finish](size_t request, DecodedImage image) {
+        finish(requests_[request], create_texture(image, requests_[request]));
+    };
+}
+
+bool TextureBatch::finish_decoded(FinishImage const& finish, bool wait)
+{
+    while (finished_ < requests_.size()) {
+        Decoded decoded{};
+        {
+            std::unique_lock lock{mutex_};
+            if (wait) {
+                decoded_available_.wait(lock, [this]() { return !decoded_.empty(); });
+            } else if (decoded_.empty()) {
+                return false;
+            }
+            decoded = std::move(decoded_.front());
+            decoded_.pop_front();
+        }
+
+        ++finished_;
+        if (decoded.error) {
+            std::rethrow_exception(decoded.error);
+        }
+
+        finish(decoded.request, std::move(*decoded.image));
+    }
+
+    return true;
+}
+
+} // namespace playground
@@ -0,0 +1,125 @@
+#ifndef PLAYGROUND_TEXTURE_LOADER_HPP
+#define PLAYGROUND_TEXTURE_LOADER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "block_compression.hpp"
+#include "mipmap.hpp"
+#include "png.hpp"
+#include "resource_manager.hpp"
+#include "texture.hpp"
+#include "texture_cache.hpp"
+#include "thread_pool.hpp"
+
+namespace playground {
+
+enum class MipGeneration {
+    None,
+    Cpu, // filtered on the decoding thread and uploaded with the base level
+    Gpu, // glGenerateMipmap after the upload, box filtered in the texture's format; Cpu for compressed textures
+};
+
+struct TextureRequest {
+    std::string path{};
+    size_t channels{}; // 1, 3 or 4
+    GLenum unit{GL_TEXTURE0};
+    MipGeneration mipmaps{MipGeneration::Cpu};
+    ColorSpace color_space{ColorSpace::Linear};
+    MipFilter mip_filter{MipFilter::Box};
+    TextureFilter filter{TextureFilter::Trilinear};
+    TextureCompression compression{TextureCompression::None}; // encoded once and cached next to the file
+};
+
+// the levels of an image, level 0 only unless its mipmaps are generated on the CPU
+using DecodedImage = std::variant<
+  std::vector<MipLevel<png::RedPixel>>,
+  std::vector<MipLevel<png::RgbPixel>>,
+  std::vector<MipLevel<png::RgbaPixel>>,
+  CompressedImage>;
+
+/*
+ * decodes the image of the request and generates its mipmaps, may run on any thread.
+ * Compressed textures are read from their cache or encoded and cached
+ */
+DecodedImage decode_image(TextureRequest const& request);
+
+/*
+ * creates a texture of the whole image, runs on the GL thread
+ */
+LoadedResource<Texture> create_texture(DecodedImage const& image, TextureRequest const& request);
+
+/*******************************************************************************
+ * decodes a batch of images concurrently on the pool, while the GL thread
+ * creates the textures of the decoded ones in the order decoding finishes,
+ * or takes the decoded images themselves, e.g. to build an atlas of them.
+ * An error of a request is rethrown by `poll` or `finish` once it is its turn
+ ******************************************************************************/
+class TextureBatch final {
+public:
+    using Finish = std::function<void(TextureRequest const&, LoadedResource<Texture>)>;
+    using FinishImage = std::function<void(size_t request, DecodedImage image)>;
+
+    TextureBatch(ThreadPool& pool, std::vector<TextureRequest> requests);
+
+    TextureBatch(TextureBatch const&) = delete;
+    TextureBatch(TextureBatch&&) = delete;
+    TextureBatch& operator=(TextureBatch const&) = delete;
+    TextureBatch& operator=(TextureBatch&&) = delete;
+
+    // the decoding tasks refer to the batch, so they are waited for
+    ~TextureBatch();
+
+    /*
+     * creates the textures of all images decoded so far and passes them to `finish`,
+     * returns true when every request of the batch is finished
+     */
+    bool poll(Finish const& finish);
+
+    /*
+     * same as `poll`, but blocks until every request of the batch is finished
+     */
+    void finish(Finish const& finish);
+
+    /*
+     * same as `poll` and `finish`, but passes the decoded images with the index
+     * of their request to `finish` instead of creating textures of them
+     */
+    bool poll_images(FinishImage const& finish);
+    void finish_images(FinishImage const& finish);
+
+private:
+    struct Decoded {
+        size_t request{};
+        std::optional<DecodedImage> image{};
+        std::exception_ptr error{};
+    };
+
+    FinishImage create_textures(Finish const& finish) const;
+
+    bool finish_decoded(FinishImage const& finish, bool wait);
+
+    std::vector<TextureRequest> requests_{};
+    std::vector<std::future<void>> tasks_{};
+    size_t finished_{};
+
+    std::mutex mutex_{};
+    std::condition_variable decoded_available_{};
+    std::deque<Decoded> decoded_{};
+};
+
+} // namespace playground
+
+#endif // PLAYGROUND_TEXTURE_LOADER_HPP
@@ -0,0 +1,174 @@
+#include "texture_residency.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+namespace playground {
+
+TextureResidency::TextureResidency(TextureStreamer& streamer, size_t budget, size_t min_resident_size) :
+  streamer_{streamer}, budget_{budget}, min_resident_size_{min_resident_size} {}
+
+TextureLayer TextureResidency::add(TextureArrayPool& pool, DecodedImage image)
+{
+    auto const shared_image = std::make_shared<DecodedImage const>(std::move(image));
+    auto layer = pool.allocate(image_format(*shared_image));
+    auto const& format = layer.array->format();
+
+    auto resident = std::find_if(residents_.begin(), residents_.end(), [&layer](auto const& resident) {
+        return resident->array == layer.array;
+    });
+    if (resident == residents_.end()) {
+        auto added = std::make_shared<Resident>();
+        added->array = layer.array;
+        added->images.resize(layer.array->layers());
+        while (added->coarsest_first_level + 1 < format.levels
+          && std::max(format.width, format.height) >> added->coarsest_first_level > min_resident_size_) {
+            ++added->coarsest_first_level;
+        }
+
+        // a new array has storage for all levels, it starts with the small ones only
+        added->array->set_first_level(added->coarsest_first_level);
+        residents_.push_back(std::move(added));
+        resident = std::prev(residents_.end());
+    }
+
+    (*resident)->images.at(layer.layer) = shared_image;
+    for (size_t level = format.levels; level-- > layer.array->first_level();) {
+        load_level(*resident, layer.layer, level);
+    }
+
+    return layer;
+}
+
+void TextureResidency::request(TextureLayer const& layer, size_t level, float priority)
+{
+    auto resident = std::find_if(residents_.begin(), residents_.end(), [&layer](auto const& resident) {
+        return resident->array == layer.array;
+    });
+    if (resident == residents_.end()) {
+        return;
+    }
+
+    auto& requested = **resident;
+    requested.requested_level = requested.requested ? std::min(requested.requested_level, level) : level;
+    requested.priority = requested.requested ? std::max(requested.priority, priority) : priority;
+    requested.requested = true;
+}
+
+void TextureResidency::remove(TextureLayer const& layer)
+{
+    auto resident = std::find_if(residents_.begin(), residents_.end(), [&layer](auto const& resident) {
+        return resident->array == layer.array;
+    });
+    if (resident == residents_.end()) {
+        return;
+    }
+
+    auto& images = (*resident)->images;
+    images.at(layer.layer).reset();
+    if (std::none_of(images.begin(), images.end(), [](auto const& image) { return image != nullptr; })) {
+        residents_.erase(resident);
+    }
+}
+
+void TextureResidency::update()
+{
+    stats_.budget = budget_;
+    stats_.loaded_levels = 0;
+    stats_.evicted_levels = 0;
+    stats_.evicted_bytes = 0;
+    stats_.over_budget_arrays = 0;
+
+    std::vector<size_t> first_levels(residents_.size());
+    size_t total_size = 0;
+    for (size_t i = 0; i < residents_.size(); ++i) {
+        auto const& resident = *residents_[i];
+        first_levels[i] = resident.requested
+          ? std::min(resident.requested_level, resident.coarsest_first_level)
+          : resident.coarsest_first_level;
+        total_size += resident_size(resident, first_levels[i]);
+    }
+    stats_.requested_bytes = total_size;
+
+    // the budget is met by dropping the finest levels of the arrays of the lowest priority first
+    std::vector<size_t> order(residents_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs) {
+        return residents_[lhs]->priority < residents_[rhs]->priority;
+    });
+    for (auto const i : order) {
+        auto const& resident = *residents_[i];
+        auto const requested_level = first_levels[i];
+        while (total_size > budget_ && first_levels[i] < resident.coarsest_first_level) {
+            total_size -= resident.array->layers() * resident.array->level_size(first_levels[i]);
+            ++first_levels[i];
+        }
+        if (first_levels[i] != requested_level) {
+            ++stats_.over_budget_arrays;
+        }
+    }
+
+    // levels are never dropped while the array is streaming, the uploads refer to them
+    for (size_t i = 0; i < residents_.size(); ++i) {
+        auto const& resident = *residents_[i];
+        auto const first_level = resident.array->first_level();
+        if (resident.pending_uploads != 0 || first_levels[i] <= first_level) {
+            continue;
+        }
+
+        auto const size_before = resident.array->layers() * resident.array->layer_size();
+        resident.array->set_first_level(first_levels[i]);
+        stats_.evicted_levels += first_levels[i] - first_level;
+        stats_.evicted_bytes += size_before - resident.array->layers() * resident.array->layer_size();
+        stats_.total_evictions += first_levels[i] - first_level;
+    }
+
+    // one finer level at a time, the arrays of the highest priority first
+    for (auto i = order.rbegin(); i != order.rend(); ++i) {
+        auto const& resident = residents_[*i];
+        if (resident->pending_uploads != 0 || first_levels[*i] >= resident->array->first_level()) {
+            continue;
+        }
+
+        auto const level = resident->array->first_level() - 1;
+        resident->array->set_first_level(level);
+        for (size_t layer = 0; layer < resident->images.size(); ++layer) {
+            if (resident->images[layer]) {
+                load_level(resident, layer, level);
+            }
+        }
+        ++stats_.loaded_levels;
+    }
+
+    stats_.resident_bytes = 0;
+    stats_.loading_arrays = 0;
+    for (auto const& resident : residents_) {
+        stats_.resident_bytes += resident->array->layers() * resident->array->layer_size();
+        stats_.loading_arrays += resident->pending_uploads != 0 ? 1 : 0;
+        resident->requested = false;
+        resident->priority = 0.0F;
+    }
+}
+
+size_t TextureResidency::resident_size(Resident const& resident, size_t first_level)
+{
+    size_t res = 0;
+    for (size_t level = first_level; level < resident.array->format().levels; ++level) {
+        res += resident.array->level_size(level);
+    }
+    return res * resident.array->layers();
+}
+
+void TextureResidency::load_level(std::shared_ptr<Resident> const& resident, size_t layer, size_t level)
+{
+    auto const& image = resident->images[layer];
+    ++resident->pending_uploads;
+    streamer_.stream({resident->array, layer}, level, image_level(*image, level), image, [resident]() {
+        // every resident level of every layer is uploaded, so all of them are sampled from now on
+        if (--resident->pending_uploads == 0) {
+            resident->array->set_loaded_level(resident->array->first_level());
+        }
+    });
+}
+
+} // namespace playground
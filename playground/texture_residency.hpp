@@ -0,0 +1,100 @@
+#ifndef PLAYGROUND_TEXTURE_RESIDENCY_HPP
+#define PLAYGROUND_TEXTURE_RESIDENCY_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "texture_array.hpp"
+#include "texture_loader.hpp"
+#include "texture_streamer.hpp"
+
+namespace playground {
+
+// the counters of the last `update` are reset by the next one
+struct ResidencyStats {
+    size_t budget{};
+    size_t resident_bytes{};
+    size_t requested_bytes{}; // the requested levels would take, regardless of the budget
+    size_t loading_arrays{}; // still streaming a finer level in
+    size_t loaded_levels{}; // finer levels started streaming in the last update
+    size_t evicted_levels{}; // in the last update
+    size_t evicted_bytes{}; // in the last update
+    size_t over_budget_arrays{}; // kept coarser than requested in the last update
+    size_t total_evictions{};
+};
+
+/*******************************************************************************
+ * keeps texture arrays under a GPU memory budget by streaming their levels
+ * in and out. The CPU copy of every layer is kept to stream levels in again.
+ * Arrays start with their small levels only, so something is displayed right
+ * away, and get one finer level at a time as long as the objects using them
+ * request it. When the requests exceed the budget, the arrays with the lowest
+ * priority are kept coarser. All layers of an array share the resident levels,
+ * so an array gets the finest level requested for any of its layers.
+ * Runs on the GL thread only
+ ******************************************************************************/
+class TextureResidency final {
+public:
+    // levels up to `min_resident_size` texels wide and high are always resident
+    TextureResidency(TextureStreamer& streamer, size_t budget, size_t min_resident_size = 64);
+
+    /*
+     * allocates a layer of the image's format from the pool, the layer starts
+     * with the levels up to the minimal resident size, or with the levels its
+     * array already has, and is managed by the residency from now on
+     */
+    TextureLayer add(TextureArrayPool& pool, DecodedImage image);
+
+    /*
+     * the finest level the layer is sampled at in this frame and how much it matters,
+     * e.g. the screen coverage of the objects using it. Arrays of layers without
+     * requests in a frame drop to the minimal resident levels
+     */
+    void request(TextureLayer const& layer, size_t level, float priority);
+
+    /*
+     * stops managing the layer and drops its image, the layer goes back to
+     * its pool by the caller. Levels of it still streaming are uploaded into
+     * the layer, a layer allocated again gets its own levels after them
+     */
+    void remove(TextureLayer const& layer);
+
+    /*
+     * evicts and streams levels to meet the requests within the budget,
+     * called once per frame after all requests of the frame
+     */
+    void update();
+
+    void set_budget(size_t budget) { budget_ = budget; }
+
+    [[nodiscard]] ResidencyStats const& stats() const { return stats_; }
+
+private:
+    struct Resident {
+        std::shared_ptr<TextureArray> array{};
+        std::vector<std::shared_ptr<DecodedImage const>> images{}; // by layer, empty for layers not added
+        size_t coarsest_first_level{};
+        size_t pending_uploads{};
+
+        // requests of the frame
+        size_t requested_level{};
+        float priority{};
+        bool requested{};
+    };
+
+    // bytes of the array with the levels from `first_level` on resident
+    static size_t resident_size(Resident const& resident, size_t first_level);
+
+    void load_level(std::shared_ptr<Resident> const& resident, size_t layer, size_t level);
+
+    TextureStreamer& streamer_;
+    size_t budget_{};
+    size_t min_resident_size_{};
+    std::vector<std::shared_ptr<Resident>> residents_{};
+    ResidencyStats stats_{};
+};
+
+} // namespace playground
+
+#endif // PLAYGROUND_TEXTURE_RESIDENCY_HPP
@@ -0,0 +1,243 @@
+#include "texture_streamer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#include <fmt/core.h>
+#include <gsl/narrow>
+
+namespace playground {
+
+TextureStreamer::TextureStreamer(size_t frame_budget, size_t frames_in_flight) :
+  frame_budget_{frame_budget}, fences_(frames_in_flight, nullptr)
+{
+    auto const size = gsl::narrow<GLsizeiptr>(frame_budget_ * frames_in_flight);
+    GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &buffer_);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer_);
+    glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+    mapped_ = static_cast<std::byte*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (mapped_ == nullptr) {
+        glDeleteBuffers(1, &buffer_);
+        throw std::runtime_error(fmt::format("Could not map a texture streaming buffer of {} bytes", size));
+    }
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    for (auto fence : fences_) {
+        if (fence != nullptr) {
+            glDeleteSync(fence);
+        }
+    }
+    // deleting a mapped buffer unmaps it
+    glDeleteBuffers(1, &buffer_);
+}
+
+void TextureStreamer::stream(
+  std::shared_ptr<Texture> texture,
+  size_t level,
+  std::span<std::byte const> data,
+  std::shared_ptr<void const> owner,
+  bool generate_mipmaps)
+{
+    auto const width = std::max(texture->width() >> level, 1UL);
+    auto const height = std::max(texture->height() >> level, 1UL);
+    auto const channels = texture->channels();
+    auto const compression = texture->compression();
+
+    Upload upload{};
+    upload.update = [texture, level, width](size_t offset, size_t size, size_t y, size_t rows) {
+        texture->upload_from_buffer(offset, size, 0, y, width, rows, level);
+    };
+    if (generate_mipmaps) {
+        upload.finish = [texture]() { texture->generate_mipmaps(); };
+    }
+    upload.data = data;
+    upload.owner = std::move(owner);
+    upload.height = height;
+    queue(std::move(upload), width, channels, compression);
+}
+
+void TextureStreamer::stream(
+  TextureLayer const& layer,
+  size_t level,
+  std::span<std::byte const> data,
+  std::shared_ptr<void const> owner,
+  std::function<void()> finish)
+{
+    auto const& format = layer.array->format();
+
+    Upload upload{};
+    upload.update = [layer, level](size_t offset, size_t size, size_t y, size_t rows) {
+        layer.array->upload_from_buffer(layer.layer, level, offset, size, y, rows);
+    };
+    upload.finish = std::move(finish);
+    upload.data = data;
+    upload.owner = std::move(owner);
+    upload.height = std::max(format.height >> level, 1UL);
+    queue(std::move(upload), std::max(format.width >> level, 1UL), format.channels, format.compression);
+}
+
+void TextureStreamer::queue(Upload upload, size_t width, size_t channels, TextureCompression compression)
+{
+    if (compression == TextureCompression::None) {
+        upload.row_bytes = width * channels;
+        upload.row_height = 1;
+    } else {
+        upload.row_bytes = (width + 3) / 4 * compressed_block_size(compression);
+        upload.row_height = 4;
+    }
+
+    auto const rows = (upload.height + upload.row_height - 1) / upload.row_height;
+    if (upload.data.size() != rows * upload.row_bytes) {
+        throw std::runtime_error(fmt::format("Expected {} bytes of a level, got {}", rows * upload.row_bytes, upload.data.size()));
+    }
+    if (upload.row_bytes > frame_budget_) {
+        throw std::runtime_error(fmt::format("A row of {} bytes exceeds the frame budget of {} bytes", upload.row_bytes, frame_budget_));
+    }
+
+    stats_.queued_bytes += upload.data.size();
+    queue_.push_back(std::move(upload));
+}
+
+void TextureStreamer::update()
+{
+    stats_.frame_bytes = 0;
+    if (queue_.empty()) {
+        return;
+    }
+
+    // the segment is still read by the GPU, writing it now would wait for the GPU
+    auto& fence = fences_[frame_ % fences_.size()];
+    if (fence != nullptr) {
+        if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            ++stats_.waiting_frames;
+            return;
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    auto const segment = (frame_ % fences_.size()) * frame_budget_;
+    size_t used = 0;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer_);
+    while (!queue_.empty()) {
+        auto& upload = queue_.front();
+        auto const total_rows = upload.data.size() / upload.row_bytes;
+        auto const rows = std::min(total_rows - upload.next_row, (frame_budget_ - used) / upload.row_bytes);
+        if (rows == 0) {
+            break;
+        }
+
+        auto const size = rows * upload.row_bytes;
+        std::memcpy(mapped_ + segment + used, upload.data.data() + upload.next_row * upload.row_bytes, size);
+
+        auto const y = upload.next_row * upload.row_height;
+        upload.update(segment + used, size, y, std::min(rows * upload.row_height, upload.height - y));
+
+        used += size;
+        upload.next_row += rows;
+        if (upload.next_row == total_rows) {
+            if (upload.finish) {
+                upload.finish();
+            }
+            queue_.pop_front();
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ++frame_;
+
+    stats_.frame_bytes = used;
+    stats_.queued_bytes -= used;
+    stats_.uploaded_bytes += used;
+}
+
+template <class PixelType>
+static LoadedResource<Texture> stream_levels(
+  TextureStreamer& streamer, std::vector<MipLevel<PixelType>> const& levels, std::shared_ptr<void const> const& owner, TextureRequest const& request)
+{
+    auto const& base = levels.front();
+    auto const gpu_mipmaps = request.mipmaps == MipGeneration::Gpu;
+    auto const level_count = gpu_mipmaps ? mip_level_count(base.width, base.height) : levels.size();
+
+    auto texture = std::make_shared<Texture>(base.width, base.height, request.channels, request.unit, level_count);
+    size_t gpu_bytes = 0;
+    for (size_t level = levels.size(); level-- > 0;) {
+        auto const data = std::as_bytes(std::span{levels[level].pixels});
+        streamer.stream(texture, level, data, owner, gpu_mipmaps);
+        gpu_bytes += data.size();
+    }
+    if (gpu_mipmaps) {
+        gpu_bytes += gpu_bytes / 3;
+    }
+    texture->set_filter(request.filter);
+
+    return LoadedResource<Texture>{texture, {0, gpu_bytes}};
+}
+
+static LoadedResource<Texture> stream_levels(
+  TextureStreamer& streamer, CompressedImage const& image, std::shared_ptr<void const> const& owner, TextureRequest const& request)
+{
+    auto texture = std::make_shared<Texture>(image.width, image.height, image.compression, request.unit, image.levels.size());
+    size_t gpu_bytes = 0;
+    for (size_t level = image.levels.size(); level-- > 0;) {
+        streamer.stream(texture, level, image.levels[level], owner);
+        gpu_bytes += image.levels[level].size();
+    }
+    texture->set_filter(request.filter);
+
+    return LoadedResource<Texture>{texture, {0, gpu_bytes}};
+}
+
+LoadedResource<Texture> stream_texture(TextureStreamer& streamer, DecodedImage image, TextureRequest const& request)
+{
+    auto const owner = std::make_shared<DecodedImage const>(std::move(image));
+    return std::visit([&](auto const& data) {
+        return stream_levels(streamer, data, owner, request);
+    }, *owner);
+}
+
+TextureFormat image_format(DecodedImage const& image)
+{
+    return std::visit([](auto const& data) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(data)>, CompressedImage>) {
+            return TextureFormat{data.width, data.height, 0, data.compression, data.levels.size()};
+        } else {
+            using PixelType = typename std::decay_t<decltype(data.front().pixels)>::value_type;
+            auto const& base = data.front();
+            return TextureFormat{base.width, base.height, png::total_channels<PixelType>::value, TextureCompression::None, data.size()};
+        }
+    }, image);
+}
+
+std::span<std::byte const> image_level(DecodedImage const& image, size_t level)
+{
+    return std::visit([level](auto const& data) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(data)>, CompressedImage>) {
+            return std::span<std::byte const>{data.levels.at(level)};
+        } else {
+            return std::as_bytes(std::span{data.at(level).pixels});
+        }
+    }, image);
+}
+
+TextureLayer stream_texture_layer(TextureStreamer& streamer, TextureArrayPool& pool, DecodedImage image)
+{
+    auto const owner = std::make_shared<DecodedImage const>(std::move(image));
+    auto layer = pool.allocate(image_format(*owner));
+    for (size_t level = layer.array->format().levels; level-- > 0;) {
+        streamer.stream(layer, level, image_level(*owner, level), owner);
+    }
+    return layer;
+}
+
+} // namespace playground
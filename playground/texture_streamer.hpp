@@ -0,0 +1,120 @@
+#ifndef PLAYGROUND_TEXTURE_STREAMER_HPP
+#define PLAYGROUND_TEXTURE_STREAMER_HPP
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <glad/glad.h>
+
+#include "resource_manager.hpp"
+#include "texture.hpp"
+#include "texture_array.hpp"
+#include "texture_loader.hpp"
+
+namespace playground {
+
+struct StreamingStats {
+    size_t queued_bytes{}; // not uploaded yet
+    size_t frame_bytes{}; // uploaded by the last `update`
+    size_t uploaded_bytes{}; // in total
+    size_t waiting_frames{}; // frames the ring was still read by the GPU, so nothing was uploaded
+};
+
+/*******************************************************************************
+ * uploads textures without stalling on client memory: pixels are copied into
+ * a persistently mapped pixel unpack buffer and the textures are updated from
+ * the buffer. The buffer is a ring of one segment per frame in flight, every
+ * segment holds the frame budget and is fenced after its uploads, so it is
+ * reused only once the GPU has read it. Levels larger than the budget are
+ * split into rows over several frames. Runs on the GL thread only
+ ******************************************************************************/
+class TextureStreamer final {
+public:
+    explicit TextureStreamer(size_t frame_budget, size_t frames_in_flight = 3);
+    ~TextureStreamer();
+
+    TextureStreamer(TextureStreamer const&) = delete;
+    TextureStreamer(TextureStreamer&&) = delete;
+    TextureStreamer& operator=(TextureStreamer const&) = delete;
+    TextureStreamer& operator=(TextureStreamer&&) = delete;
+
+    /*
+     * queues a level of the texture, `data` holds its pixels or blocks like
+     * `upload` or `upload_compressed` take them and is kept by `owner`
+     * until the level is uploaded, as is the texture
+     */
+    void stream(
+      std::shared_ptr<Texture> texture,
+      size_t level,
+      std::span<std::byte const> data,
+      std::shared_ptr<void const> owner,
+      bool generate_mipmaps = false);
+
+    /*
+     * the same for a level of a layer of a texture array, `finish` is called once the level is uploaded
+     */
+    void stream(
+      TextureLayer const& layer,
+      size_t level,
+      std::span<std::byte const> data,
+      std::shared_ptr<void const> owner,
+      std::function<void()> finish = {});
+
+    /*
+     * uploads up to the frame budget of the queued levels, called once per frame
+     */
+    void update();
+
+    [[nodiscard]] bool idle() const { return queue_.empty(); }
+
+    [[nodiscard]] StreamingStats const& stats() const { return stats_; }
+
+private:
+    struct Upload {
+        // updates texel rows from the bound unpack buffer: buffer offset, size, first row, number of rows
+        std::function<void(size_t, size_t, size_t, size_t)> update{};
+        std::function<void()> finish{}; // after the last rows, may be empty
+        std::span<std::byte const> data{};
+        std::shared_ptr<void const> owner{};
+        size_t height{}; // of the level in texels
+        size_t row_bytes{}; // a row of pixels or of blocks
+        size_t row_height{};
+        size_t next_row{};
+    };
+
+    void queue(Upload upload, size_t width, size_t channels, TextureCompression compression);
+
+    size_t frame_budget_{};
+    size_t frame_{};
+    GLuint buffer_{};
+    std::byte* mapped_{};
+    std::vector<GLsync> fences_{};
+    std::deque<Upload> queue_{};
+    StreamingStats stats_{};
+};
+
+/*
+ * creates a texture of the image with storage for all of its levels and
+ * queues the levels from the smallest one, runs on the GL thread. The texture
+ * may be sampled as soon as it is returned, levels not uploaded yet are undefined
+ */
+LoadedResource<Texture> stream_texture(TextureStreamer& streamer, DecodedImage image, TextureRequest const& request);
+
+// the format of a texture array the image is a layer of
+TextureFormat image_format(DecodedImage const& image);
+
+// the pixels or the blocks of a level of the image
+std::span<std::byte const> image_level(DecodedImage const& image, size_t level);
+
+/*
+ * the same, but the image becomes a layer of an array of the pool, it needs all of its levels
+ */
+TextureLayer stream_texture_layer(TextureStreamer& streamer, TextureArrayPool& pool, DecodedImage image);
+
+} // namespace playground
+
+#endif // PLAYGROUND_TEXTURE_STREAMER_HPP
@@ -0,0 +1,42 @@
+#include "thread_pool.hpp"
+
+namespace playground {
+
+ThreadPool::ThreadPool(size_t thread_count)
+{
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back([this]() { run_worker(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard const lock{mutex_};
+        stopping_ = true;
+    }
+    task_available_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run_worker()
+{
+    while (true) {
+        std::function<void()> task{};
+        {
+            std::unique_lock lock{mutex_};
+            task_available_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return; // stopping and nothing left to do
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task();
+    }
+}
+
+} // namespace playground
@@ -0,0 +1,66 @@
+#ifndef PLAYGROUND_THREAD_POOL_HPP
+#define PLAYGROUND_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "parallel_for.hpp"
+
+namespace playground {
+
+/*******************************************************************************
+ * a fixed set of worker threads running submitted tasks in submission order.
+ * The destructor finishes all queued tasks before joining the workers
+ ******************************************************************************/
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count = default_thread_count());
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+
+    ThreadPool& operator=(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    ~ThreadPool();
+
+    [[nodiscard]] size_t thread_count() const { return workers_.size(); }
+
+    /*
+     * queues `fn` and returns a future of its result,
+     * an exception thrown by `fn` is rethrown by the future's `get`
+     */
+    template <class Function>
+    std::future<std::invoke_result_t<Function>> submit(Function fn)
+    {
+        // std::function requires a copyable callable, a packaged task is move-only
+        auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Function>()>>(std::move(fn));
+        auto res = task->get_future();
+        {
+            std::lock_guard const lock{mutex_};
+            tasks_.emplace([task = std::move(task)]() { (*task)(); });
+        }
+        task_available_.notify_one();
+        return res;
+    }
+
+private:
+    std::vector<std::thread> workers_{};
+    std::queue<std::function<void()>> tasks_{};
+    std::mutex mutex_{};
+    std::condition_variable task_available_{};
+    bool stopping_{false};
+
+    void run_worker();
+};
+
+} // namespace playground
+
+#endif // PLAYGROUND_THREAD_POOL_HPP